@@ -0,0 +1,141 @@
+#include "aig.h"
+#include <stdexcept>
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+class AigBuilder {
+public:
+    explicit AigBuilder(Aig& aig) : aig_(aig) {}
+
+    uint32_t andLit(uint32_t a, uint32_t b) {
+        if (a > b) std::swap(a, b);
+        if (a == Aig::kFalse || a == (b ^ 1)) return Aig::kFalse;
+        if (a == Aig::kTrue || a == b) return b;
+        uint64_t key = static_cast<uint64_t>(a) << 32 | b;
+        auto it = strash_.find(key);
+        if (it != strash_.end()) return it->second;
+        uint32_t lit = static_cast<uint32_t>(2 * aig_.numNodes());
+        aig_.fanin.push_back(a);
+        aig_.fanin.push_back(b);
+        strash_.emplace(key, lit);
+        return lit;
+    }
+    uint32_t orLit(uint32_t a, uint32_t b) { return andLit(a ^ 1, b ^ 1) ^ 1; }
+    uint32_t xorLit(uint32_t a, uint32_t b) { return orLit(andLit(a, b ^ 1), andLit(a ^ 1, b)); }
+    uint32_t muxLit(uint32_t s, uint32_t t, uint32_t e) {
+        if (t == e) return t;
+        return orLit(andLit(s, t), andLit(s ^ 1, e));
+    }
+
+    // Literals of net's outputs given literals for its inputs.
+    std::vector<uint32_t> lower(const Net& net, const std::vector<uint32_t>& ins) {
+        if (net.cyclic) throw std::runtime_error("AIG engine does not support feedback loops");
+        std::vector<uint32_t> lit(net.numSignals(), Aig::kFalse);
+        lit[Net::kConst1] = Aig::kTrue;
+        for (size_t i = 0; i < net.inputIds.size(); ++i) lit[net.inputIds[i]] = ins[i];
+        for (const auto& g : net.gates) {
+            uint32_t a = lit[g.in1], b = lit[g.in2];
+            switch (g.op) {
+                case GateOp::Not: lit[g.out] = a ^ 1; break;
+                case GateOp::And: lit[g.out] = andLit(a, b); break;
+                case GateOp::Or: lit[g.out] = orLit(a, b); break;
+                case GateOp::Xor: lit[g.out] = xorLit(a, b); break;
+                case GateOp::Nand: lit[g.out] = andLit(a, b) ^ 1; break;
+                case GateOp::Nor: lit[g.out] = orLit(a, b) ^ 1; break;
+                case GateOp::Sub: {
+                    const Net::SubInstance& inst = net.subs[g.sub];
+                    std::vector<uint32_t> subIns;
+                    for (uint32_t s : inst.ins) subIns.push_back(lit[s]);
+                    std::vector<uint32_t> subOuts = lower(inst.net[0], subIns);
+                    for (size_t i = 0; i < inst.outs.size(); ++i) lit[inst.outs[i]] = subOuts[i];
+                    break;
+                }
+                case GateOp::Lut: {
+                    const Net::LutInstance& lut = net.luts[g.sub];
+                    std::vector<uint32_t> x;
+                    for (uint32_t s : lut.ins) x.push_back(lit[s]);
+                    lit[g.out] = lutLit(lut.bits(), 0, static_cast<unsigned>(x.size()), x);
+                    break;
+                }
+            }
+        }
+        std::vector<uint32_t> outs;
+        for (uint32_t s : net.outputIds) outs.push_back(lit[s]);
+        return outs;
+    }
+
+private:
+    Aig& aig_;
+    std::unordered_map<uint64_t, uint32_t> strash_;
+
+    // Shannon expansion of rows [first, first + 2^k) on the top input.
+    uint32_t lutLit(const uint64_t* table, size_t first, unsigned k, const std::vector<uint32_t>& x) {
+        if (k == 0) return (table[first / 64] >> (first % 64)) & 1 ? Aig::kTrue : Aig::kFalse;
+        size_t half = size_t{1} << (k - 1);
+        uint32_t lo = lutLit(table, first, k - 1, x);
+        uint32_t hi = lutLit(table, first + half, k - 1, x);
+        return muxLit(x[k - 1], hi, lo);
+    }
+};
+}
+
+uint32_t Aig::depth() const {
+    std::vector<uint32_t> d(numNodes(), 0);
+    uint32_t first = numInputs + 1;
+    for (size_t k = 0; k < numAnds(); ++k) {
+        d[first + k] = 1 + std::max(d[node(fanin[2 * k])], d[node(fanin[2 * k + 1])]);
+    }
+    uint32_t best = 0;
+    for (uint32_t lit : outputs) best = std::max(best, d[node(lit)]);
+    return best;
+}
+
+Aig buildAig(const Net& net) {
+    std::vector<uint32_t> ins(net.inputIds.size());
+    for (uint32_t i = 0; i < ins.size(); ++i) ins[i] = i;
+    return buildAig({&net}, {ins}, static_cast<uint32_t>(ins.size()));
+}
+
+Aig buildAig(const std::vector<const Net*>& nets, const std::vector<std::vector<uint32_t>>& inputs,
+             uint32_t numInputs) {
+    Aig aig;
+    aig.numInputs = numInputs;
+    AigBuilder builder(aig);
+    for (size_t k = 0; k < nets.size(); ++k) {
+        std::vector<uint32_t> ins;
+        for (uint32_t i : inputs[k]) ins.push_back(Aig::inputLit(i));
+        std::vector<uint32_t> outs = builder.lower(*nets[k], ins);
+        aig.outputs.insert(aig.outputs.end(), outs.begin(), outs.end());
+    }
+    return aig;
+}
+
+AigSim::AigSim(std::shared_ptr<const Aig> aig, size_t words)
+    : WordSim(aig->numInputs, words), aig_(std::move(aig)),
+      val_(aig_->numNodes() * words_, 0), out_(aig_->outputs.size() * words_, 0) {}
+
+std::unique_ptr<WordSim> AigSim::fork() const {
+    return std::make_unique<AigSim>(aig_, words_);
+}
+
+void AigSim::run() {
+    const Aig& g = *aig_;
+    const size_t n = words_;
+    const uint32_t* f = g.fanin.data();
+    uint64_t* o = node(g.numInputs + 1);
+    for (size_t k = 0; k < g.numAnds(); ++k, o += n) {
+        uint32_t la = f[2 * k], lb = f[2 * k + 1];
+        const uint64_t* a = val_.data() + static_cast<size_t>(Aig::node(la)) * n;
+        const uint64_t* b = val_.data() + static_cast<size_t>(Aig::node(lb)) * n;
+        uint64_t ca = 0 - static_cast<uint64_t>(la & 1);
+        uint64_t cb = 0 - static_cast<uint64_t>(lb & 1);
+        for (size_t w = 0; w < n; ++w) o[w] = (a[w] ^ ca) & (b[w] ^ cb);
+    }
+    for (size_t i = 0; i < g.outputs.size(); ++i) {
+        uint32_t lit = g.outputs[i];
+        const uint64_t* v = val_.data() + static_cast<size_t>(Aig::node(lit)) * n;
+        uint64_t c = 0 - static_cast<uint64_t>(lit & 1);
+        for (size_t w = 0; w < n; ++w) out_[i * n + w] = v[w] ^ c;
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef AIG_H
+#define AIG_H
+
+#include "simulator.h"
+#include "bitsim.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// And-Inverter Graph form of an acyclic net. Node 0 is constant false,
+// nodes 1..numInputs are the primary inputs, and every further node is a
+// two-input AND. Edges are literals, 2*node + complement, so inverters
+// cost nothing and there is a single node type to evaluate.
+struct Aig {
+    static constexpr uint32_t kFalse = 0;
+    static constexpr uint32_t kTrue = 1;
+
+    uint32_t numInputs = 0;
+    std::vector<uint32_t> fanin;    // AND node numInputs+1+k reads literals fanin[2k] and fanin[2k+1]
+    std::vector<uint32_t> outputs;  // one literal per net output
+
+    static uint32_t node(uint32_t lit) { return lit >> 1; }
+    static bool complemented(uint32_t lit) { return lit & 1; }
+    static uint32_t inputLit(uint32_t i) { return 2 * (i + 1); }
+
+    size_t numAnds() const { return fanin.size() / 2; }
+    size_t numNodes() const { return 1 + numInputs + numAnds(); }
+    // Longest path from an input to an output, counted in ANDs.
+    uint32_t depth() const;
+};
+
+// Lowers every gate, sub-instance and lookup table of an acyclic net.
+// Identical ANDs are shared (structural hashing) and trivial ones such as
+// x&0 or x&!x are folded while building. Throws for cyclic nets.
+Aig buildAig(const Net& net);
+// Lowers several nets into one AIG over numInputs shared inputs, so any
+// structure they have in common is built once (a miter, for instance).
+// Input i of nets[k] is AIG input inputs[k][i]; the outputs are those of
+// nets[0], then nets[1], and so on.
+Aig buildAig(const std::vector<const Net*>& nets, const std::vector<std::vector<uint32_t>>& inputs,
+             uint32_t numInputs);
+
+// Word-parallel evaluator over an AIG. Nodes are stored in topological
+// order, so run() is one pass of (a ^ ca) & (b ^ cb) per node with the
+// complement masks derived from the literal bits, without branches.
+class AigSim : public WordSim {
+public:
+    AigSim(std::shared_ptr<const Aig> aig, size_t words = 1);
+
+    uint64_t* input(size_t i) override { return node(static_cast<uint32_t>(i) + 1); }
+    const uint64_t* output(size_t i) const override { return out_.data() + i * words_; }
+    void run() override;
+    std::unique_ptr<WordSim> fork() const override;
+
+    const Aig& aig() const { return *aig_; }
+
+private:
+    std::shared_ptr<const Aig> aig_;
+    std::vector<uint64_t> val_;
+    std::vector<uint64_t> out_;
+
+    uint64_t* node(uint32_t n) { return val_.data() + static_cast<size_t>(n) * words_; }
+};
+
+#endif
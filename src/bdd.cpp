@@ -0,0 +1,463 @@
+#include "bdd.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
+
+namespace {
+constexpr size_t kInitialBuckets = 16;
+constexpr size_t kInitialCache = size_t{1} << 16;
+constexpr size_t kMaxCache = size_t{1} << 22;
+// Garbage is collected once this many dead nodes make up half the tables
+constexpr size_t kMinDead = size_t{1} << 14;
+constexpr size_t kFirstReorder = size_t{1} << 16;
+// A variable stops moving in one direction once the tables grow by a fifth
+constexpr size_t kMaxGrowthDivisor = 5;
+// Swaps per reordering after which no further variable is sifted
+constexpr size_t kMaxSwaps = 2000;
+
+size_t hashPair(uint32_t lo, uint32_t hi) {
+    uint64_t h = (static_cast<uint64_t>(lo) << 32 | hi) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h >> 32);
+}
+
+size_t hashTriple(uint32_t f, uint32_t g, uint32_t h) {
+    uint64_t x = (static_cast<uint64_t>(f) << 32 | g) * 0x9E3779B97F4A7C15ull;
+    x ^= (x >> 29) + h * 0xBF58476D1CE4E5B9ull;
+    return static_cast<size_t>(x ^ (x >> 32));
+}
+}
+
+Bdd::Bdd(BddManager* mgr, uint32_t edge) : mgr_(mgr), edge_(edge) {
+    mgr_->ref(edge_);
+}
+
+Bdd::Bdd(const Bdd& other) : mgr_(other.mgr_), edge_(other.edge_) {
+    if (mgr_) mgr_->ref(edge_);
+}
+
+Bdd& Bdd::operator=(Bdd other) noexcept {
+    std::swap(mgr_, other.mgr_);
+    std::swap(edge_, other.edge_);
+    return *this;
+}
+
+Bdd::~Bdd() {
+    if (mgr_) mgr_->deref(edge_);
+}
+
+Bdd Bdd::operator&(const Bdd& other) const {
+    return mgr_->ite(*this, other, mgr_->constant(false));
+}
+
+Bdd Bdd::operator|(const Bdd& other) const {
+    return mgr_->ite(*this, mgr_->constant(true), other);
+}
+
+Bdd Bdd::operator^(const Bdd& other) const {
+    return mgr_->ite(*this, ~other, other);
+}
+
+BddManager::BddManager(uint32_t numVars, size_t nodeLimit)
+    : nodes_(1, Node{kFreeVar, 0, 0, 1, 0}), cache_(kInitialCache), nodeLimit_(nodeLimit),
+      nextReorder_(kFirstReorder) {
+    for (uint32_t v = 0; v < numVars; ++v) addVar();
+}
+
+uint32_t BddManager::addVar() {
+    uint32_t v = numVars();
+    level_.push_back(v);
+    order_.push_back(v);
+    tables_.emplace_back();
+    tables_.back().buckets.assign(kInitialBuckets, 0);
+    return v;
+}
+
+Bdd BddManager::var(uint32_t v) {
+    if (v >= numVars()) throw std::runtime_error("BDD variable " + std::to_string(v) + " out of range");
+    return Bdd(this, makeNode(v, 0, 1));
+}
+
+void BddManager::ref(uint32_t edge) {
+    uint32_t n = edge >> 1;
+    if (n != 0 && nodes_[n].ref++ == 0) --dead_;
+}
+
+void BddManager::deref(uint32_t edge) {
+    uint32_t n = edge >> 1;
+    if (n != 0 && --nodes_[n].ref == 0) ++dead_;
+}
+
+uint32_t BddManager::makeNode(uint32_t var, uint32_t lo, uint32_t hi) {
+    if (lo == hi) return lo;
+    // Keep the low edge regular by moving its complement to the result
+    uint32_t c = lo & 1;
+    lo ^= c;
+    hi ^= c;
+    const Subtable& t = tables_[var];
+    for (uint32_t n = t.buckets[hashPair(lo, hi) & (t.buckets.size() - 1)]; n; n = nodes_[n].next) {
+        if (nodes_[n].lo == lo && nodes_[n].hi == hi) return 2 * n ^ c;
+    }
+    if (nodeLimit_ && live_ >= nodeLimit_) throw BddLimitError();
+    uint32_t n;
+    if (!free_.empty()) {
+        n = free_.back();
+        free_.pop_back();
+    } else {
+        n = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    nodes_[n] = {var, lo, hi, 0, 0};
+    ref(lo);
+    ref(hi);
+    ++live_;
+    ++dead_;
+    insert(n);
+    return 2 * n ^ c;
+}
+
+void BddManager::insert(uint32_t n) {
+    Subtable& t = tables_[nodes_[n].var];
+    if (++t.count > 2 * t.buckets.size()) {
+        std::vector<uint32_t> old(t.buckets.size() * 4, 0);
+        old.swap(t.buckets);
+        for (uint32_t head : old) {
+            for (uint32_t m = head, next; m; m = next) {
+                next = nodes_[m].next;
+                uint32_t& b = t.buckets[hashPair(nodes_[m].lo, nodes_[m].hi) & (t.buckets.size() - 1)];
+                nodes_[m].next = b;
+                b = m;
+            }
+        }
+    }
+    uint32_t& b = t.buckets[hashPair(nodes_[n].lo, nodes_[n].hi) & (t.buckets.size() - 1)];
+    nodes_[n].next = b;
+    b = n;
+}
+
+void BddManager::unlink(uint32_t n) {
+    Subtable& t = tables_[nodes_[n].var];
+    uint32_t* p = &t.buckets[hashPair(nodes_[n].lo, nodes_[n].hi) & (t.buckets.size() - 1)];
+    while (*p != n) p = &nodes_[*p].next;
+    *p = nodes_[n].next;
+    --t.count;
+}
+
+// Frees a node without references, and with it any children left without.
+void BddManager::release(uint32_t n) {
+    unlink(n);
+    uint32_t lo = nodes_[n].lo, hi = nodes_[n].hi;
+    nodes_[n].var = kFreeVar;
+    free_.push_back(n);
+    --live_;
+    --dead_;
+    // Both references go before either child is freed: they may be one node
+    deref(lo);
+    deref(hi);
+    releaseIfDead(lo);
+    releaseIfDead(hi);
+}
+
+void BddManager::releaseIfDead(uint32_t edge) {
+    uint32_t n = edge >> 1;
+    if (n != 0 && nodes_[n].var != kFreeVar && nodes_[n].ref == 0) release(n);
+}
+
+void BddManager::collectGarbage() {
+    for (uint32_t n = 1; n < nodes_.size(); ++n) {
+        if (nodes_[n].var != kFreeVar && nodes_[n].ref == 0) release(n);
+    }
+    std::fill(cache_.begin(), cache_.end(), CacheEntry());
+}
+
+// Runs between top-level operations, when no unreferenced result is in flight.
+void BddManager::maintain() {
+    if (dead_ > kMinDead && 2 * dead_ > live_) collectGarbage();
+    if (autoReorder_ && live_ - dead_ >= nextReorder_) {
+        reorder();
+        nextReorder_ = std::max(2 * nextReorder_, 2 * live_);
+    }
+    if (live_ > cache_.size() && cache_.size() < kMaxCache) cache_.assign(cache_.size() * 2, CacheEntry());
+}
+
+Bdd BddManager::ite(const Bdd& f, const Bdd& g, const Bdd& h) {
+    maintain();
+    return Bdd(this, iteRec(f.edge_, g.edge_, h.edge_));
+}
+
+uint32_t BddManager::iteRec(uint32_t f, uint32_t g, uint32_t h) {
+    if (f == 1) return g;
+    if (f == 0) return h;
+    if (g == f) g = 1;
+    else if (g == (f ^ 1)) g = 0;
+    if (h == f) h = 0;
+    else if (h == (f ^ 1)) h = 1;
+    if (g == h) return g;
+    if (g == 1 && h == 0) return f;
+    if (g == 0 && h == 1) return f ^ 1;
+    // Normal form for the cache: f and g regular
+    if (f & 1) {
+        f ^= 1;
+        std::swap(g, h);
+    }
+    uint32_t c = g & 1;
+    g ^= c;
+    h ^= c;
+
+    CacheEntry& e = cache_[hashTriple(f, g, h) & (cache_.size() - 1)];
+    if (e.f == f && e.g == g && e.h == h) return e.result ^ c;
+
+    uint32_t v = order_[std::min({levelOf(f), levelOf(g), levelOf(h)})];
+    uint32_t lo = iteRec(cofactor(f, v, false), cofactor(g, v, false), cofactor(h, v, false));
+    uint32_t hi = iteRec(cofactor(f, v, true), cofactor(g, v, true), cofactor(h, v, true));
+    uint32_t r = makeNode(v, lo, hi);
+    e = {f, g, h, r};
+    return r ^ c;
+}
+
+double BddManager::satCount(const Bdd& f) const {
+    const int n = static_cast<int>(numVars());
+    std::unordered_map<uint32_t, double> memo;
+    // Assignments to the variables at levels from..n-1 under which edge is
+    // true (from is at most the edge's level)
+    std::function<double(uint32_t, uint32_t)> count = [&](uint32_t edge, uint32_t from) {
+        uint32_t node = edge >> 1;
+        uint32_t level = node == 0 ? static_cast<uint32_t>(n) : level_[nodes_[node].var];
+        double c = 0;
+        if (node != 0) {
+            auto it = memo.find(node);
+            if (it != memo.end()) {
+                c = it->second;
+            } else {
+                c = count(nodes_[node].lo, level + 1) + count(nodes_[node].hi, level + 1);
+                memo[node] = c;
+            }
+        }
+        if (edge & 1) c = std::ldexp(1.0, n - static_cast<int>(level)) - c;
+        return std::ldexp(c, static_cast<int>(level - from));
+    };
+    return count(f.edge_, 0);
+}
+
+std::vector<int> BddManager::satisfyingAssignment(const Bdd& f) const {
+    if (f.isFalse()) return {};
+    std::vector<int> values(numVars(), 0);
+    for (uint32_t e = f.edge_; (e >> 1) != 0;) {
+        const Node& n = nodes_[e >> 1];
+        uint32_t lo = n.lo ^ (e & 1);
+        if (lo != 0) {
+            e = lo;
+        } else {
+            values[n.var] = 1;
+            e = n.hi ^ (e & 1);
+        }
+    }
+    return values;
+}
+
+bool BddManager::evaluate(const Bdd& f, const std::vector<int>& values) const {
+    uint32_t e = f.edge_;
+    while ((e >> 1) != 0) {
+        const Node& n = nodes_[e >> 1];
+        e = (values[n.var] ? n.hi : n.lo) ^ (e & 1);
+    }
+    return e == 1;
+}
+
+size_t BddManager::nodeCount(const std::vector<Bdd>& roots) const {
+    std::vector<uint8_t> seen(nodes_.size(), 0);
+    std::vector<uint32_t> stack;
+    for (const Bdd& r : roots) stack.push_back(r.edge_ >> 1);
+    size_t count = 0;
+    while (!stack.empty()) {
+        uint32_t n = stack.back();
+        stack.pop_back();
+        if (n == 0 || seen[n]) continue;
+        seen[n] = 1;
+        ++count;
+        stack.push_back(nodes_[n].lo >> 1);
+        stack.push_back(nodes_[n].hi >> 1);
+    }
+    return count;
+}
+
+void BddManager::setOrder(const std::vector<uint32_t>& order) {
+    std::vector<uint32_t> sorted = order;
+    std::sort(sorted.begin(), sorted.end());
+    for (uint32_t i = 0; i < sorted.size(); ++i) {
+        if (sorted[i] != i || sorted.size() != numVars()) {
+            throw std::runtime_error("BDD variable order is not a permutation of the variables");
+        }
+    }
+    if (live_ > 0) collectGarbage();
+    if (live_ > 0) throw std::runtime_error("BDD variable order can only change while no nodes exist");
+    order_ = order;
+    for (uint32_t l = 0; l < order_.size(); ++l) level_[order_[l]] = l;
+}
+
+// Exchanges the variables at levels l and l+1 in place. A node of the upper
+// variable x that tests the lower y, f = x ? (y ? f11 : f10) : (y ? f01 : f00),
+// becomes y ? (x ? f11 : f01) : (x ? f10 : f00) and keeps its index, so the
+// edges pointing at it stay valid. Other nodes are unchanged.
+void BddManager::swapLevels(uint32_t l) {
+    ++swaps_;
+    uint32_t x = order_[l], y = order_[l + 1];
+    std::vector<uint32_t> xs;
+    for (uint32_t& head : tables_[x].buckets) {
+        for (uint32_t n = head; n; n = nodes_[n].next) xs.push_back(n);
+        head = 0;
+    }
+    tables_[x].count = 0;
+    auto testsY = [&](uint32_t edge) { return (edge >> 1) != 0 && nodes_[edge >> 1].var == y; };
+    std::vector<uint32_t> moved;
+    for (uint32_t n : xs) {
+        if (testsY(nodes_[n].lo) || testsY(nodes_[n].hi)) moved.push_back(n);
+        else insert(n);
+    }
+    for (uint32_t n : moved) {
+        uint32_t f0 = nodes_[n].lo, f1 = nodes_[n].hi;
+        uint32_t lo = makeNode(x, cofactor(f0, y, false), cofactor(f1, y, false));
+        ref(lo);
+        uint32_t hi = makeNode(x, cofactor(f0, y, true), cofactor(f1, y, true));
+        ref(hi);
+        nodes_[n].var = y;
+        nodes_[n].lo = lo;
+        nodes_[n].hi = hi;
+        insert(n);
+        deref(f0);
+        deref(f1);
+        releaseIfDead(f0);
+        releaseIfDead(f1);
+    }
+    std::swap(order_[l], order_[l + 1]);
+    level_[x] = l + 1;
+    level_[y] = l;
+}
+
+void BddManager::siftVar(uint32_t var) {
+    const uint32_t n = numVars();
+    const size_t limit = live_ + live_ / kMaxGrowthDivisor;
+    size_t best = live_;
+    uint32_t bestLevel = level_[var];
+    auto note = [&]() {
+        if (live_ < best) {
+            best = live_;
+            bestLevel = level_[var];
+        }
+        return live_ <= limit;
+    };
+    auto down = [&]() {
+        while (level_[var] + 1 < n) {
+            swapLevels(level_[var]);
+            if (!note()) break;
+        }
+    };
+    auto up = [&]() {
+        while (level_[var] > 0) {
+            swapLevels(level_[var] - 1);
+            if (!note()) break;
+        }
+    };
+    // Visit the nearer end first
+    if (level_[var] >= n / 2) {
+        down();
+        up();
+    } else {
+        up();
+        down();
+    }
+    while (level_[var] < bestLevel) swapLevels(level_[var]);
+    while (level_[var] > bestLevel) swapLevels(level_[var] - 1);
+}
+
+void BddManager::reorder() {
+    // Swaps may briefly need more nodes than the limit allows
+    size_t limit = nodeLimit_;
+    nodeLimit_ = 0;
+    collectGarbage();
+    std::vector<uint32_t> vars(numVars());
+    for (uint32_t v = 0; v < vars.size(); ++v) vars[v] = v;
+    std::stable_sort(vars.begin(), vars.end(),
+                     [&](uint32_t a, uint32_t b) { return tables_[a].count > tables_[b].count; });
+    swaps_ = 0;
+    for (uint32_t v : vars) {
+        if (swaps_ >= kMaxSwaps) break;
+        siftVar(v);
+    }
+    std::fill(cache_.begin(), cache_.end(), CacheEntry());
+    nodeLimit_ = limit;
+}
+
+std::vector<uint32_t> aigInputOrder(const Aig& aig) {
+    // Depth of each node, to take the deeper fanin first
+    std::vector<uint32_t> depth(aig.numNodes(), 0);
+    const uint32_t firstAnd = aig.numInputs + 1;
+    for (size_t k = 0; k < aig.numAnds(); ++k) {
+        depth[firstAnd + k] =
+            1 + std::max(depth[Aig::node(aig.fanin[2 * k])], depth[Aig::node(aig.fanin[2 * k + 1])]);
+    }
+    std::vector<uint32_t> order;
+    std::vector<uint8_t> seen(aig.numNodes(), 0);
+    std::vector<uint32_t> stack;
+    for (uint32_t o : aig.outputs) {
+        stack.push_back(Aig::node(o));
+        while (!stack.empty()) {
+            uint32_t n = stack.back();
+            stack.pop_back();
+            if (n == 0 || seen[n]) continue;
+            seen[n] = 1;
+            if (n < firstAnd) {
+                order.push_back(n - 1);
+                continue;
+            }
+            uint32_t a = Aig::node(aig.fanin[2 * (n - firstAnd)]), b = Aig::node(aig.fanin[2 * (n - firstAnd) + 1]);
+            if (depth[a] > depth[b]) std::swap(a, b);
+            stack.push_back(a);
+            stack.push_back(b);
+        }
+    }
+    for (uint32_t i = 0; i < aig.numInputs; ++i) {
+        if (!seen[i + 1]) order.push_back(i);
+    }
+    return order;
+}
+
+std::vector<Bdd> buildBdds(BddManager& mgr, const Aig& aig) {
+    while (mgr.numVars() < aig.numInputs) mgr.addVar();
+    if (mgr.liveNodes() == 0) {
+        std::vector<uint32_t> order = aigInputOrder(aig);
+        for (uint32_t v = aig.numInputs; v < mgr.numVars(); ++v) order.push_back(v);
+        mgr.setOrder(order);
+    }
+
+    // Only the outputs' cones are built, and each AND's BDD is dropped once
+    // its last reader has been built
+    const uint32_t firstAnd = aig.numInputs + 1;
+    std::vector<uint32_t> uses(aig.numNodes(), 0);
+    for (uint32_t o : aig.outputs) ++uses[Aig::node(o)];
+    for (size_t k = aig.numAnds(); k-- > 0;) {
+        if (!uses[firstAnd + k]) continue;
+        ++uses[Aig::node(aig.fanin[2 * k])];
+        ++uses[Aig::node(aig.fanin[2 * k + 1])];
+    }
+    std::vector<Bdd> val(aig.numNodes());
+    val[0] = mgr.constant(false);
+    for (uint32_t i = 0; i < aig.numInputs; ++i) val[i + 1] = mgr.var(i);
+    auto literal = [&](uint32_t l) { return Aig::complemented(l) ? ~val[Aig::node(l)] : val[Aig::node(l)]; };
+    for (size_t k = 0; k < aig.numAnds(); ++k) {
+        uint32_t n = firstAnd + static_cast<uint32_t>(k);
+        if (!uses[n]) continue;
+        uint32_t x = aig.fanin[2 * k], y = aig.fanin[2 * k + 1];
+        val[n] = literal(x) & literal(y);
+        for (uint32_t l : {x, y}) {
+            if (--uses[Aig::node(l)] == 0 && Aig::node(l) >= firstAnd) val[Aig::node(l)] = Bdd();
+        }
+    }
+    std::vector<Bdd> outs;
+    for (uint32_t o : aig.outputs) outs.push_back(literal(o));
+    return outs;
+}
+
+std::vector<Bdd> buildBdds(BddManager& mgr, const Net& net) {
+    return buildBdds(mgr, buildAig(net));
+}
@@ -0,0 +1,158 @@
+#ifndef BDD_H
+#define BDD_H
+
+#include "aig.h"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+class BddManager;
+
+// Thrown when an operation would take a manager past its node limit. The
+// manager stays usable; the partial result is reclaimed as garbage.
+struct BddLimitError : std::runtime_error {
+    BddLimitError() : std::runtime_error("BDD node limit exceeded") {}
+};
+
+// Reference-counted handle on a function held by a BddManager. Within one
+// manager the representation is canonical, so two handles are the same
+// function exactly when they compare equal. Handles must not outlive
+// their manager.
+class Bdd {
+public:
+    Bdd() = default;
+    Bdd(const Bdd& other);
+    Bdd(Bdd&& other) noexcept : mgr_(other.mgr_), edge_(other.edge_) { other.mgr_ = nullptr; }
+    Bdd& operator=(Bdd other) noexcept;
+    ~Bdd();
+
+    bool operator==(const Bdd& other) const { return edge_ == other.edge_; }
+    bool operator!=(const Bdd& other) const { return edge_ != other.edge_; }
+    Bdd operator~() const { return Bdd(mgr_, edge_ ^ 1); }
+    Bdd operator&(const Bdd& other) const;
+    Bdd operator|(const Bdd& other) const;
+    Bdd operator^(const Bdd& other) const;
+
+    bool isFalse() const { return edge_ == 0; }
+    bool isTrue() const { return edge_ == 1; }
+    // 2*node + complement: an id that is equal for equal functions
+    uint32_t edge() const { return edge_; }
+
+private:
+    friend class BddManager;
+    Bdd(BddManager* mgr, uint32_t edge);
+
+    BddManager* mgr_ = nullptr;
+    uint32_t edge_ = 0;
+};
+
+// Reduced ordered BDDs with complement edges. Node 0 is the constant and
+// edge 0 is false; a node's low edge is never complemented, which keeps
+// negation free and the form canonical. Each variable has its own unique
+// table so that adjacent levels can be swapped in place, and ite() results
+// are cached in a direct-mapped computed table. Nodes whose count of
+// parents and handles drops to zero stay in the tables until garbage
+// collection, which runs between top-level operations once enough of them
+// pile up. With auto-reordering on, the manager also sifts variables
+// (Rudell) whenever the node count doubles since the last reordering.
+class BddManager {
+public:
+    explicit BddManager(uint32_t numVars = 0, size_t nodeLimit = 0);
+    BddManager(const BddManager&) = delete;
+    BddManager& operator=(const BddManager&) = delete;
+
+    // A new variable, placed below all others in the order.
+    uint32_t addVar();
+    uint32_t numVars() const { return static_cast<uint32_t>(level_.size()); }
+
+    Bdd constant(bool value) { return Bdd(this, value ? 1 : 0); }
+    Bdd var(uint32_t v);
+    // if f then g else h
+    Bdd ite(const Bdd& f, const Bdd& g, const Bdd& h);
+
+    // Number of assignments to all numVars() variables that make f true.
+    // Exact while below 2^53.
+    double satCount(const Bdd& f) const;
+    // One satisfying assignment, one value per variable (0 where f does not
+    // care), or empty when f is false.
+    std::vector<int> satisfyingAssignment(const Bdd& f) const;
+    bool evaluate(const Bdd& f, const std::vector<int>& values) const;
+    // Distinct non-constant nodes reachable from the roots.
+    size_t nodeCount(const std::vector<Bdd>& roots) const;
+    // Nodes in the unique tables, including ones not yet collected.
+    size_t liveNodes() const { return live_; }
+
+    // Variables from the top of the order to the bottom.
+    std::vector<uint32_t> order() const { return order_; }
+    // Replaces the order; only while the manager holds no nodes.
+    void setOrder(const std::vector<uint32_t>& order);
+    void setAutoReorder(bool enabled) { autoReorder_ = enabled; }
+    // Sifts every variable to the level that minimizes the node count.
+    void reorder();
+    void collectGarbage();
+
+private:
+    static constexpr uint32_t kFreeVar = UINT32_MAX;
+
+    struct Node {
+        uint32_t var, lo, hi;
+        uint32_t ref;   // parents plus handles
+        uint32_t next;  // unique-table chain
+    };
+    struct Subtable {
+        std::vector<uint32_t> buckets;  // chain heads, 0 for none
+        size_t count = 0;
+    };
+    struct CacheEntry {
+        uint32_t f = UINT32_MAX, g, h, result;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+    std::vector<Subtable> tables_;  // per variable
+    std::vector<uint32_t> level_, order_;
+    std::vector<CacheEntry> cache_;
+    size_t live_ = 0, dead_ = 0, nodeLimit_;
+    bool autoReorder_ = true;
+    size_t nextReorder_;
+    size_t swaps_ = 0;
+
+    uint32_t levelOf(uint32_t edge) const {
+        uint32_t n = edge >> 1;
+        return n == 0 ? UINT32_MAX : level_[nodes_[n].var];
+    }
+    // Children of edge for the value of var, with its complement applied
+    uint32_t cofactor(uint32_t edge, uint32_t var, bool value) const {
+        const Node& n = nodes_[edge >> 1];
+        if ((edge >> 1) == 0 || n.var != var) return edge;
+        return (value ? n.hi : n.lo) ^ (edge & 1);
+    }
+
+    void ref(uint32_t edge);
+    void deref(uint32_t edge);
+    uint32_t makeNode(uint32_t var, uint32_t lo, uint32_t hi);
+    void insert(uint32_t n);
+    void unlink(uint32_t n);
+    void release(uint32_t n);
+    void releaseIfDead(uint32_t edge);
+    uint32_t iteRec(uint32_t f, uint32_t g, uint32_t h);
+    void maintain();
+    void swapLevels(uint32_t level);
+    void siftVar(uint32_t var);
+
+    friend class Bdd;
+};
+
+// Inputs in the order a depth-first walk from the outputs reaches them,
+// which keeps related inputs (a_i, b_i of an adder) next to each other.
+std::vector<uint32_t> aigInputOrder(const Aig& aig);
+// The canonical function of each AIG output, with AIG input i as BDD
+// variable i. Adds variables as needed, and when mgr holds no nodes yet
+// starts from aigInputOrder(). Throws BddLimitError.
+std::vector<Bdd> buildBdds(BddManager& mgr, const Aig& aig);
+// The same for an acyclic net, one BDD per net output. Throws for nets
+// with feedback loops.
+std::vector<Bdd> buildBdds(BddManager& mgr, const Net& net);
+
+#endif
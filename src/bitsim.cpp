@@ -0,0 +1,443 @@
+#include "bitsim.h"
+#include "gate_kernels.h"
+#include "aig.h"
+#include "native.h"
+#include "cone_table.h"
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Lane patterns for the low six row-index bits: bit j of kLanePattern[i]
+// is bit i of j.
+static const uint64_t kLanePattern[6] = {
+    0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+    0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull,
+};
+
+const char* simEngineName(SimEngine engine) {
+    switch (engine) {
+        case SimEngine::Aig: return "aig";
+        case SimEngine::Native: return "native";
+        default: return "netlist";
+    }
+}
+
+bool simEngineByName(const std::string& name, SimEngine& engine) {
+    if (name == "netlist") engine = SimEngine::Netlist;
+    else if (name == "aig") engine = SimEngine::Aig;
+    else if (name == "native") engine = SimEngine::Native;
+    else return false;
+    return true;
+}
+
+std::unique_ptr<WordSim> makeWordSim(const Net& net, SimEngine engine, size_t words) {
+    if (!BitSim::supports(net)) throw std::runtime_error("Word-parallel simulation needs an acyclic net");
+    if (engine == SimEngine::Aig) return std::make_unique<AigSim>(std::make_shared<const Aig>(buildAig(net)), words);
+    if (engine == SimEngine::Native) {
+        return std::make_unique<NativeSim>(std::make_shared<const NativeModule>(compileNative(net)), words);
+    }
+    return std::make_unique<BitSim>(net, words);
+}
+
+uint64_t WordSim::comboWord(size_t i, uint64_t word) {
+    if (i < 6) return kLanePattern[i];
+    if (i < 70) return ((word >> (i - 6)) & 1) ? ~0ull : 0;
+    return 0;
+}
+
+void WordSim::loadCombos(uint64_t base) {
+    uint64_t word0 = base / 64;
+    for (size_t i = 0; i < inputs_; ++i) {
+        uint64_t* in = input(i);
+        for (size_t w = 0; w < words_; ++w) in[w] = comboWord(i, word0 + w);
+    }
+}
+
+BitSim::BitSim(const Net& net, size_t words)
+    : WordSim(net.inputIds.size(), words), net_(net),
+      val_(static_cast<size_t>(net.numSignals()) * words_, 0) {
+    std::fill_n(sig(Net::kConst1), words_, ~0ull);
+    subs_.resize(net.subs.size());
+    for (size_t i = 0; i < net.subs.size(); ++i) {
+        subs_[i] = std::make_unique<BitSim>(net.subs[i].net[0], words_);
+    }
+    std::map<std::pair<const uint64_t*, size_t>, std::shared_ptr<const std::vector<LutStep>>> programs;
+    size_t maxSteps = 0;
+    lutSteps_.resize(net.luts.size());
+    for (size_t i = 0; i < net.luts.size(); ++i) {
+        const Net::LutInstance& lut = net.luts[i];
+        if (lut.ins.size() <= 6) continue;
+        auto& steps = programs[{lut.table->data(), lut.column}];
+        if (!steps) steps = std::make_shared<const std::vector<LutStep>>(lutSteps(lut));
+        lutSteps_[i] = steps;
+        maxSteps = std::max(maxSteps, steps->size());
+    }
+    if (maxSteps) {
+        lutVals_.assign(2 + maxSteps, 0);
+        lutVals_[1] = ~0ull;
+    }
+}
+
+BitSim::~BitSim() = default;
+
+bool BitSim::supports(const Net& net) {
+    if (net.cyclic) return false;
+    for (const auto& inst : net.subs) {
+        if (!supports(inst.net[0])) return false;
+    }
+    return true;
+}
+
+std::unique_ptr<WordSim> BitSim::fork() const {
+    return std::make_unique<BitSim>(net_, words_);
+}
+
+void BitSim::runSub(const Net::Gate& g) {
+    const Net::SubInstance& inst = net_.subs[g.sub];
+    BitSim& sub = *subs_[g.sub];
+    for (size_t i = 0; i < inst.ins.size(); ++i) {
+        std::copy_n(sig(inst.ins[i]), words_, sub.input(i));
+    }
+    sub.run();
+    for (size_t i = 0; i < inst.outs.size(); ++i) {
+        std::copy_n(sub.output(i), words_, sig(inst.outs[i]));
+    }
+}
+
+// Shannon expansion of a table over k <= 6 inputs: the top input selects
+// between the two half tables, and uniform sub-tables become constants.
+static uint64_t lutWord(uint64_t table, unsigned k, const uint64_t* x) {
+    uint64_t rows = 1ull << k;
+    uint64_t mask = rows == 64 ? ~0ull : (1ull << rows) - 1;
+    table &= mask;
+    if (table == 0) return 0;
+    if (table == mask) return ~0ull;
+    unsigned half = static_cast<unsigned>(rows / 2);
+    uint64_t lo = lutWord(table & ((1ull << half) - 1), k - 1, x);
+    uint64_t hi = lutWord(table >> half, k - 1, x);
+    return (lo & ~x[k - 1]) | (hi & x[k - 1]);
+}
+
+std::vector<LutStep> lutSteps(const Net::LutInstance& lut) {
+    const uint64_t* bits = lut.bits();
+    std::vector<LutStep> steps;
+    std::map<std::vector<uint64_t>, uint32_t> seen;  // sub-table, prefixed by its input count
+    // Rows [first, first + 2^k) of the table as a value index
+    std::function<uint32_t(uint64_t, unsigned)> build = [&](uint64_t first, unsigned k) -> uint32_t {
+        std::vector<uint64_t> key{k};
+        if (k >= 6) {
+            key.insert(key.end(), bits + first / 64, bits + first / 64 + (1ull << (k - 6)));
+        } else {
+            uint64_t mask = (1ull << (1u << k)) - 1;
+            key.push_back((bits[first / 64] >> (first % 64)) & mask);
+            if (key[1] == 0) return 0;
+            if (key[1] == mask) return 1;
+        }
+        if (std::all_of(key.begin() + 1, key.end(), [](uint64_t w) { return w == 0; })) return 0;
+        if (std::all_of(key.begin() + 1, key.end(), [](uint64_t w) { return w == ~0ull; })) return 1;
+        auto it = seen.find(key);
+        if (it != seen.end()) return it->second;
+        uint32_t lo = build(first, k - 1);
+        uint32_t hi = build(first + (1ull << (k - 1)), k - 1);
+        if (lo == hi) return seen[key] = lo;
+        steps.push_back({k - 1, lo, hi});
+        return seen[key] = static_cast<uint32_t>(steps.size() + 1);
+    };
+    uint32_t out = build(0, static_cast<unsigned>(lut.ins.size()));
+    if (out < 2 || out != steps.size() + 1) steps.push_back({0, out, out});
+    return steps;
+}
+
+void BitSim::runLut(const Net::Gate& g) {
+    const Net::LutInstance& lut = net_.luts[g.sub];
+    unsigned k = static_cast<unsigned>(lut.ins.size());
+    uint64_t x[64];
+    uint64_t* o = sig(g.out);
+    if (k <= 6) {
+        for (size_t w = 0; w < words_; ++w) {
+            for (unsigned j = 0; j < k; ++j) x[j] = sig(lut.ins[j])[w];
+            o[w] = lutWord(lut.bits()[0], k, x);
+        }
+        return;
+    }
+    // Wider tables run their precomputed mux steps
+    const std::vector<LutStep>& steps = *lutSteps_[g.sub];
+    uint64_t* v = lutVals_.data();
+    for (size_t w = 0; w < words_; ++w) {
+        for (unsigned j = 0; j < k; ++j) x[j] = sig(lut.ins[j])[w];
+        for (size_t i = 0; i < steps.size(); ++i) {
+            const LutStep& s = steps[i];
+            v[i + 2] = (v[s.lo] & ~x[s.sel]) | (v[s.hi] & x[s.sel]);
+        }
+        o[w] = v[steps.size() + 1];
+    }
+}
+
+void BitSim::runGate(const GateKernels& k, const Net::Gate& g) {
+    if (g.op == GateOp::Sub) {
+        runSub(g);
+        return;
+    }
+    if (g.op == GateOp::Lut) {
+        runLut(g);
+        return;
+    }
+    const size_t n = words_;
+    const uint64_t* a = sig(g.in1);
+    const uint64_t* b = sig(g.in2);
+    uint64_t* o = sig(g.out);
+    switch (g.op) {
+        case GateOp::Not: k.notOp(o, a, n); break;
+        case GateOp::And: k.andOp(o, a, b, n); break;
+        case GateOp::Or: k.orOp(o, a, b, n); break;
+        case GateOp::Xor: k.xorOp(o, a, b, n); break;
+        case GateOp::Nand: k.nandOp(o, a, b, n); break;
+        case GateOp::Nor: k.norOp(o, a, b, n); break;
+        default: break;
+    }
+}
+
+void BitSim::run() {
+    const GateKernels& k = gateKernels();
+    for (const auto& g : net_.gates) runGate(k, g);
+    settled_ = true;
+}
+
+void BitSim::buildCones() {
+    cones_.assign(inputs_, {});
+    std::vector<uint32_t> seen(net_.gates.size(), Net::kNoSignal), work;
+    for (uint32_t i = 0; i < inputs_; ++i) {
+        std::vector<uint32_t>& cone = cones_[i];
+        work.assign(1, net_.inputIds[i]);
+        while (!work.empty()) {
+            uint32_t s = work.back();
+            work.pop_back();
+            for (uint32_t f = net_.fanStart[s]; f < net_.fanStart[s + 1]; ++f) {
+                uint32_t gi = net_.fanGate[f];
+                if (seen[gi] == i) continue;
+                seen[gi] = i;
+                cone.push_back(gi);
+                net_.forEachOutput(net_.gates[gi], [&](uint32_t o) { work.push_back(o); });
+            }
+        }
+        std::sort(cone.begin(), cone.end());  // gates are in topological order
+    }
+}
+
+void BitSim::runCombos(uint64_t base) {
+    if (!settled_) {
+        loadCombos(base);
+        run();
+        return;
+    }
+    uint64_t word0 = base / 64;
+    changed_.clear();
+    for (size_t i = 0; i < inputs_; ++i) {
+        uint64_t* in = input(i);
+        bool differs = false;
+        for (size_t w = 0; w < words_; ++w) {
+            uint64_t x = comboWord(i, word0 + w);
+            differs |= in[w] != x;
+            in[w] = x;
+        }
+        if (differs) changed_.push_back(static_cast<uint32_t>(i));
+    }
+    if (changed_.empty()) return;
+    if (cones_.empty()) buildCones();
+    const std::vector<uint32_t>* gates = &cones_[changed_[0]];
+    if (changed_.size() > 1) {
+        merged_.clear();
+        for (uint32_t i : changed_) merged_.insert(merged_.end(), cones_[i].begin(), cones_[i].end());
+        std::sort(merged_.begin(), merged_.end());
+        merged_.erase(std::unique(merged_.begin(), merged_.end()), merged_.end());
+        gates = &merged_;
+    }
+    const GateKernels& k = gateKernels();
+    for (uint32_t gi : *gates) runGate(k, net_.gates[gi]);
+}
+
+// Blocks are simulated in groups of kGrayGroup consecutive ones, visited in
+// Gray-code order (j ^ j/2) so that each differs from the previous in one
+// input; outs[k] receives block first+k, so callers still see row order.
+static constexpr uint64_t kGrayGroup = 8;
+
+static void simulateGroup(WordSim& sim, uint64_t first, uint64_t count, uint64_t blockRows, size_t nout,
+                          std::vector<std::vector<uint64_t>>& outs) {
+    size_t words = sim.words();
+    outs.resize(kGrayGroup);
+    for (uint64_t j = 0; j < kGrayGroup; ++j) {
+        uint64_t k = j ^ (j >> 1);
+        if (k >= count) continue;
+        sim.runCombos((first + k) * blockRows);
+        outs[k].resize(nout * words);
+        for (size_t o = 0; o < nout; ++o) std::copy_n(sim.output(o), words, outs[k].data() + o * words);
+    }
+}
+
+// Expands the blocks of a group from cone tables instead of simulating them.
+static void expandGroup(const std::vector<ConeTable>& cones, uint64_t first, uint64_t count, size_t words,
+                        std::vector<std::vector<uint64_t>>& outs) {
+    outs.resize(kGrayGroup);
+    for (uint64_t k = 0; k < count; ++k) {
+        outs[k].resize(cones.size() * words);
+        uint64_t word0 = (first + k) * words;
+        for (size_t o = 0; o < cones.size(); ++o) {
+            for (size_t w = 0; w < words; ++w) outs[k][o * words + w] = cones[o].word(word0 + w);
+        }
+    }
+}
+
+// Cone tables pay off when the outputs' supports together need fewer rows
+// than the whole enumeration.
+static std::vector<ConeTable> conesFor(const Net& net, SimEngine engine, uint64_t rows) {
+    if (net.outputIds.empty() || coneRows(net) >= rows) return {};
+    return buildConeTables(net, engine);
+}
+
+void enumerateTruthTable(Net& net, const std::function<void(const TruthBlock&)>& fn, size_t words,
+                         SimEngine engine) {
+    size_t nin = net.inputIds.size(), nout = net.outputIds.size();
+    uint64_t rows = InputVectors(nin).size();
+    words = static_cast<size_t>(std::min<uint64_t>(words, (rows + 63) / 64));
+    uint64_t blockRows = 64ull * words;
+    std::vector<uint64_t> outs(nout * words);
+
+    if (BitSim::supports(net)) {
+        std::vector<ConeTable> cones = conesFor(net, engine, rows);
+        std::unique_ptr<WordSim> sim = cones.empty() ? makeWordSim(net, engine, words) : nullptr;
+        uint64_t blocks = (rows + blockRows - 1) / blockRows;
+        std::vector<std::vector<uint64_t>> group;
+        for (uint64_t first = 0; first < blocks; first += kGrayGroup) {
+            uint64_t count = std::min(kGrayGroup, blocks - first);
+            if (sim) simulateGroup(*sim, first, count, blockRows, nout, group);
+            else expandGroup(cones, first, count, words, group);
+            for (uint64_t k = 0; k < count; ++k) {
+                uint64_t base = (first + k) * blockRows;
+                fn({base, std::min(blockRows, rows - base), words, &group[k]});
+            }
+        }
+        return;
+    }
+
+    std::vector<uint8_t> in(nin), out(nout);
+    for (uint64_t base = 0; base < rows; base += blockRows) {
+        InputVectors block(nin, base, std::min(blockRows, rows - base));
+        std::fill(outs.begin(), outs.end(), 0);
+        for (InputVector v : block) {
+            v.unpack(in.data(), nin);
+            simulate(net, in.data(), out.data());
+            uint64_t r = v.row - base;
+            for (size_t o = 0; o < nout; ++o) outs[o * words + r / 64] |= static_cast<uint64_t>(out[o]) << (r % 64);
+        }
+        fn({base, block.size(), words, &outs});
+    }
+}
+
+void enumerateTruthTableParallel(Net& net, unsigned threads,
+                                 const std::function<void(const TruthBlock&, std::string&)>& format,
+                                 const std::function<void(const std::string&)>& emit,
+                                 size_t words, SimEngine engine) {
+    size_t nin = net.inputIds.size(), nout = net.outputIds.size();
+    uint64_t rows = InputVectors(nin).size();
+    words = static_cast<size_t>(std::min<uint64_t>(words, (rows + 63) / 64));
+    uint64_t blockRows = 64ull * words;
+    uint64_t blocks = (rows + blockRows - 1) / blockRows;
+    uint64_t groups = (blocks + kGrayGroup - 1) / kGrayGroup;
+    threads = static_cast<unsigned>(std::min<uint64_t>(std::max(threads, 1u), groups));
+
+    if (threads == 1 || !BitSim::supports(net)) {
+        std::string text;
+        enumerateTruthTable(net, [&](const TruthBlock& block) {
+            text.clear();
+            format(block, text);
+            emit(text);
+        }, words, engine);
+        return;
+    }
+
+    // Workers take whole groups of blocks. Blocks in flight are bounded by a
+    // ring of slots so memory stays flat however large the table is; block b
+    // lives in slot b % window.
+    const uint64_t window = 2 * kGrayGroup * threads;
+    std::vector<std::string> slot(window);
+    std::vector<char> ready(window, 0);
+    std::mutex mu;
+    std::condition_variable cv;
+    std::atomic<uint64_t> next{0};
+    uint64_t emitted = 0;
+    bool failed = false;
+    std::exception_ptr error;
+
+    // Compiled once here; every worker forks its own state from it. With
+    // cone tables the workers only expand them.
+    std::vector<ConeTable> cones = conesFor(net, engine, rows);
+    std::unique_ptr<WordSim> proto = cones.empty() ? makeWordSim(net, engine, words) : nullptr;
+    auto worker = [&]() {
+        try {
+            std::unique_ptr<WordSim> sim = proto ? proto->fork() : nullptr;
+            std::vector<std::vector<uint64_t>> group;
+            std::string text;
+            for (uint64_t g = next++; g < groups; g = next++) {
+                uint64_t first = g * kGrayGroup, count = std::min(kGrayGroup, blocks - first);
+                if (sim) simulateGroup(*sim, first, count, blockRows, nout, group);
+                else expandGroup(cones, first, count, words, group);
+                for (uint64_t k = 0; k < count; ++k) {
+                    uint64_t b = first + k;
+                    {
+                        std::unique_lock<std::mutex> lock(mu);
+                        cv.wait(lock, [&] { return failed || b < emitted + window; });
+                        if (failed) return;
+                    }
+                    uint64_t base = b * blockRows;
+                    text.clear();
+                    format({base, std::min(blockRows, rows - base), words, &group[k]}, text);
+                    std::lock_guard<std::mutex> lock(mu);
+                    slot[b % window].swap(text);
+                    ready[b % window] = 1;
+                    cv.notify_all();
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mu);
+            if (!error) error = std::current_exception();
+            failed = true;
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) pool.emplace_back(worker);
+    std::string text;
+    while (emitted < blocks) {
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait(lock, [&] { return failed || ready[emitted % window]; });
+            if (failed) break;
+            text.swap(slot[emitted % window]);
+            ready[emitted % window] = 0;
+        }
+        try {
+            emit(text);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mu);
+            if (!error) error = std::current_exception();
+            failed = true;
+        }
+        std::lock_guard<std::mutex> lock(mu);
+        if (failed) break;
+        emitted++;
+        cv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if (emitted < blocks) failed = true;
+        cv.notify_all();
+    }
+    for (auto& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+}
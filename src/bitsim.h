@@ -0,0 +1,150 @@
+#ifndef BITSIM_H
+#define BITSIM_H
+
+#include "simulator.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct GateKernels;
+
+// Word-parallel engines. All evaluate 64 input vectors per machine word
+// and need an acyclic net; they differ in the form they run.
+enum class SimEngine {
+    Netlist,  // BitSim: the built gates, through the kernels in gate_kernels.h
+    Aig,      // AigSim: the net lowered to an And-Inverter Graph (aig.h)
+    Native,   // NativeSim: the net compiled to a shared library (native.h)
+};
+
+const char* simEngineName(SimEngine engine);
+// Parses "netlist", "aig" or "native"; returns false for anything else.
+bool simEngineByName(const std::string& name, SimEngine& engine);
+
+// Common interface of the word-parallel engines. Every signal holds
+// `words` machine words; bit j of word w is input vector 64*w + j.
+class WordSim {
+public:
+    virtual ~WordSim() = default;
+
+    size_t words() const { return words_; }
+    virtual uint64_t* input(size_t i) = 0;
+    virtual const uint64_t* output(size_t i) const = 0;
+    virtual void run() = 0;
+
+    // A simulator with fresh state for the same net, sharing whatever the
+    // engine compiled from it. Used to give every worker thread its own.
+    virtual std::unique_ptr<WordSim> fork() const = 0;
+
+    // Loads rows [base, base + 64*words) of the exhaustive enumeration,
+    // where input i takes bit i of the row index (same order as InputVectors).
+    void loadCombos(uint64_t base);
+
+    // loadCombos(base) followed by run(). Engines that can re-simulate
+    // only what changed since their previous run() override this.
+    virtual void runCombos(uint64_t base) {
+        loadCombos(base);
+        run();
+    }
+
+    // Input i's value in enumeration word `word` (rows 64*word and up).
+    static uint64_t comboWord(size_t i, uint64_t word);
+
+protected:
+    WordSim(size_t inputs, size_t words) : inputs_(inputs), words_(std::max<size_t>(words, 1)) {}
+
+    size_t inputs_;
+    size_t words_;
+};
+
+// Feedback loops carry state between vectors, which lanes cannot model, so
+// cyclic nets must check BitSim::supports() first. Throws for unsupported nets.
+std::unique_ptr<WordSim> makeWordSim(const Net& net, SimEngine engine, size_t words = 1);
+
+// A lookup table as a Shannon mux with equal sub-tables shared, for tables
+// too wide for one word: step i is x[sel] ? v[hi] : v[lo], where x are the
+// table's inputs, v[0] and v[1] the constants 0 and ~0, v[2 + i] the result
+// of step i, and the last step is the output.
+struct LutStep {
+    uint32_t sel, lo, hi;
+};
+std::vector<LutStep> lutSteps(const Net::LutInstance& lut);
+
+// Bit-parallel evaluator for acyclic nets: each gate costs one bitwise
+// operation per word for 64 vectors. Gates are applied through the
+// CPU-dispatched kernels in gate_kernels.h.
+class BitSim : public WordSim {
+public:
+    BitSim(const Net& net, size_t words = 1);
+    ~BitSim() override;
+
+    static bool supports(const Net& net);
+
+    uint64_t* input(size_t i) override { return sig(net_.inputIds[i]); }
+    const uint64_t* output(size_t i) const override { return sig(net_.outputIds[i]); }
+    void run() override;
+    std::unique_ptr<WordSim> fork() const override;
+
+    // Incremental: compares the new input columns with the ones of the last
+    // run() and re-evaluates only the fanout cones of inputs that differ.
+    // Between consecutive blocks only the inputs above the block size can
+    // change, usually one of them. Inputs must not have been written since
+    // the last run().
+    void runCombos(uint64_t base) override;
+
+private:
+    const Net& net_;
+    std::vector<uint64_t> val_;
+    std::vector<std::unique_ptr<BitSim>> subs_;
+    bool settled_ = false;                     // val_ reflects the current inputs
+    std::vector<std::vector<uint32_t>> cones_; // per input: gates in its fanout, in order
+    std::vector<uint32_t> changed_, merged_;
+    // lutSteps() per Net::luts entry over more than 6 inputs, and their v[]
+    std::vector<std::shared_ptr<const std::vector<LutStep>>> lutSteps_;
+    std::vector<uint64_t> lutVals_;
+
+    uint64_t* sig(uint32_t s) { return val_.data() + static_cast<size_t>(s) * words_; }
+    const uint64_t* sig(uint32_t s) const { return val_.data() + static_cast<size_t>(s) * words_; }
+    void runSub(const Net::Gate& g);
+    void runLut(const Net::Gate& g);
+    void runGate(const GateKernels& k, const Net::Gate& g);
+    void buildCones();
+};
+
+// One block of an exhaustive truth table: rows [base, base + count).
+struct TruthBlock {
+    uint64_t base, count;
+    size_t words;
+    const std::vector<uint64_t>* outs;  // output o occupies words [o*words, (o+1)*words)
+
+    int out(size_t o, uint64_t row) const {
+        uint64_t r = row - base;
+        return static_cast<int>(((*outs)[o * words + r / 64] >> (r % 64)) & 1);
+    }
+};
+
+// Simulates all 2^n input combinations of net and hands each block to fn in
+// row order. Blocks are simulated in small groups visited in Gray-code
+// order, so each differs from the previous one in a single input and the
+// incremental engines only redo that input's fanout cone. When the
+// outputs depend on few inputs each (Net::outputSupport), every output is
+// instead simulated over its own support and the blocks are expanded from
+// those cone tables (cone_table.h). Acyclic nets run on the chosen
+// word-parallel engine; cyclic nets are stepped one vector at a time with
+// simulate() so latch state carries over as before.
+void enumerateTruthTable(Net& net, const std::function<void(const TruthBlock&)>& fn, size_t words = 64,
+                         SimEngine engine = SimEngine::Netlist);
+
+// Multi-threaded variant: the rows are split into disjoint groups of blocks
+// that `threads` workers simulate, each with its own engine instance.
+// format() runs on the worker that simulated a block; emit() runs on the
+// calling thread and receives the formatted blocks strictly in row order.
+// Cyclic nets fall back to a single thread.
+void enumerateTruthTableParallel(Net& net, unsigned threads,
+                                 const std::function<void(const TruthBlock&, std::string&)>& format,
+                                 const std::function<void(const std::string&)>& emit,
+                                 size_t words = 64, SimEngine engine = SimEngine::Netlist);
+
+#endif
@@ -0,0 +1,100 @@
+#include "bytecode.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MINLAB_COMPUTED_GOTO 1
+#endif
+
+// Opcodes share the GateOp numbering so compiling a gate is a cast. A
+// feedback loop is compiled as {kLoop, loop index, body length}, the body,
+// and a kEnd; the whole program ends with kEnd too.
+enum : uint32_t { kNot, kAnd, kOr, kXor, kNand, kNor, kSub, kLut, kLoop, kEnd };
+static_assert(static_cast<uint32_t>(GateOp::Lut) == kLut, "opcodes must mirror GateOp");
+
+void compileBytecode(Net& net) {
+    net.code.clear();
+    net.code.reserve(net.gates.size() + 2 * net.loops.size() + 1);
+    for (uint32_t gi = 0; gi < net.gates.size(); ++gi) {
+        uint32_t l = net.loopOf[gi];
+        if (l != Net::kNoSignal && net.loops[l].begin == gi) {
+            net.code.push_back({kLoop, l, net.loops[l].end - gi, 0});
+        }
+        const Net::Gate& g = net.gates[gi];
+        uint32_t op = static_cast<uint32_t>(g.op);
+        if (g.op == GateOp::Sub || g.op == GateOp::Lut) net.code.push_back({op, g.sub, 0, g.out});
+        else net.code.push_back({op, g.in1, g.in2, g.out});
+        if (l != Net::kNoSignal && net.loops[l].end == gi + 1) net.code.push_back({kEnd, 0, 0, 0});
+    }
+    net.code.push_back({kEnd, 0, 0, 0});
+}
+
+// Executes instructions from pc up to the next end marker; returns
+// non-zero if any signal changed value.
+static uint8_t execute(Net& net, const Net::Instr* pc, std::vector<uint8_t>& scratch) {
+    uint8_t* v = net.val.data();
+    uint8_t changed = 0;
+#define WRITE(sig, x)                \
+    do {                             \
+        uint8_t nv_ = (x);           \
+        changed |= v[sig] ^ nv_;     \
+        v[sig] = nv_;                \
+    } while (0)
+
+#ifdef MINLAB_COMPUTED_GOTO
+    static const void* const kDispatch[] = {&&op_not, &&op_and, &&op_or,  &&op_xor,  &&op_nand,
+                                            &&op_nor, &&op_sub, &&op_lut, &&op_loop, &&op_end};
+#define OP(name, code) op_##name:
+#define NEXT() goto *kDispatch[(++pc)->op]
+    goto *kDispatch[pc->op];
+#else
+#define OP(name, code) case code:
+#define NEXT() \
+    ++pc;      \
+    continue
+    for (;;) {
+        switch (pc->op) {
+#endif
+    OP(not, kNot) WRITE(pc->out, v[pc->a] ^ 1); NEXT();
+    OP(and, kAnd) WRITE(pc->out, v[pc->a] & v[pc->b]); NEXT();
+    OP(or, kOr) WRITE(pc->out, v[pc->a] | v[pc->b]); NEXT();
+    OP(xor, kXor) WRITE(pc->out, v[pc->a] ^ v[pc->b]); NEXT();
+    OP(nand, kNand) WRITE(pc->out, (v[pc->a] & v[pc->b]) ^ 1); NEXT();
+    OP(nor, kNor) WRITE(pc->out, (v[pc->a] | v[pc->b]) ^ 1); NEXT();
+    OP(sub, kSub) {
+        Net::SubInstance& inst = net.subs[pc->a];
+        size_t nin = inst.ins.size();
+        scratch.resize(nin + inst.outs.size());
+        for (size_t i = 0; i < nin; ++i) scratch[i] = v[inst.ins[i]];
+        inst.net[0].mode = SimMode::Bytecode;
+        simulate(inst.net[0], scratch.data(), scratch.data() + nin);
+        for (size_t i = 0; i < inst.outs.size(); ++i) WRITE(inst.outs[i], scratch[nin + i]);
+        NEXT();
+    }
+    OP(lut, kLut) {
+        const Net::LutInstance& lut = net.luts[pc->a];
+        size_t row = 0;
+        for (size_t j = 0; j < lut.ins.size(); ++j) row |= static_cast<size_t>(v[lut.ins[j]]) << j;
+        WRITE(pc->out, (lut.bits()[row / 64] >> (row % 64)) & 1);
+        NEXT();
+    }
+    OP(loop, kLoop) {
+        // Run the body until a pass changes nothing, then skip past its kEnd
+        int pass = 0;
+        while (pass < Net::kLoopPasses && execute(net, pc + 1, scratch)) ++pass;
+        if (pass == Net::kLoopPasses) net.loops[pc->a].oscillating = true;
+        changed |= pass > 0;
+        pc += pc->b + 1;
+        NEXT();
+    }
+    OP(end, kEnd) return changed;
+#ifndef MINLAB_COMPUTED_GOTO
+        }
+    }
+#endif
+#undef OP
+#undef NEXT
+#undef WRITE
+}
+
+void runBytecode(Net& net, std::vector<uint8_t>& scratch) {
+    execute(net, net.code.data(), scratch);
+}
@@ -0,0 +1,15 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "simulator.h"
+
+// Emits net.code from net.gates, one instruction per gate in topological
+// order. levelizeNet calls this, so the program always matches the gates.
+void compileBytecode(Net& net);
+
+// Runs net.code over net.val, which must already hold the input values.
+// Each feedback loop is iterated until a pass changes nothing, with the
+// same Net::kLoopPasses limit as the levelized simulator.
+void runBytecode(Net& net, std::vector<uint8_t>& scratch);
+
+#endif
@@ -155,6 +155,10 @@ void ComponentDesigner::createNewComponent() {
         TerminalUI::setColor(32, -1);
         std::cout << "\nComponent '" << componentName_ << "' saved successfully!\n";
         TerminalUI::resetColor();
+        std::vector<std::string> duplicates = library_.findDuplicates(componentName_);
+        if (!duplicates.empty()) {
+            std::cout << "Note: it computes the same function as '" << duplicates[0] << "'.\n";
+        }
     } else {
         TerminalUI::setColor(31, -1);
         std::cout << "\nError: Failed to save component! Make sure it only uses NAND gates and custom components.\n";
@@ -195,7 +199,17 @@ void ComponentDesigner::showComponentList() {
                 if (j > 0) std::cout << ", ";
                 std::cout << comp.outputs[j];
             }
-            std::cout << "\n\n";
+            std::cout << "\n";
+            std::vector<std::string> duplicates = library_.findDuplicates(comp.name);
+            if (!duplicates.empty()) {
+                std::cout << "     Same function as: ";
+                for (size_t j = 0; j < duplicates.size(); ++j) {
+                    if (j > 0) std::cout << ", ";
+                    std::cout << duplicates[j];
+                }
+                std::cout << "\n";
+            }
+            std::cout << "\n";
         }
     }
     
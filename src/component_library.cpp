@@ -1,5 +1,7 @@
 #include "component_library.h"
 #include "simulator.h"
+#include "bitsim.h"
+#include "net_optimizer.h"
 #include <fstream>
 #include <sstream>
 #include <filesystem>
@@ -8,10 +10,16 @@
 #include <regex>
 #include <cstdlib>
 #include <algorithm>
+#include <functional>
 
 namespace fs = std::filesystem;
 
-ComponentLibrary::ComponentLibrary() {
+namespace {
+// Nodes the library's BDDs may take; larger components get no signature
+constexpr size_t kLibraryBddNodes = size_t{1} << 20;
+}
+
+ComponentLibrary::ComponentLibrary() : bdds_(std::make_unique<BddManager>(0, kLibraryBddNodes)) {
 }
 
 ComponentLibrary::~ComponentLibrary() {
@@ -109,9 +117,8 @@ bool ComponentLibrary::parseComponentFile(const std::string& filePath, Component
         component.inputs = component.ast.inputs;
         component.outputs = component.ast.outputs;
         
-        // Build net for simulation
-        component.net = buildNet(component.ast);
-        
+        // The net is built by loadComponents once every component is known,
+        // since parts may refer to other custom components
         return true;
     } catch (const std::exception& e) {
         // Component has invalid HDL
@@ -150,8 +157,51 @@ bool ComponentLibrary::validateComponent(const Component& component) const {
     return true;
 }
 
+void ComponentLibrary::buildLut(Component& component) const {
+    component.lut.reset();
+    size_t nin = component.net.inputIds.size();
+    if (nin > lutMaxInputs_ || !BitSim::supports(component.net)) return;
+    
+    size_t words = nin > 6 ? (size_t{1} << nin) / 64 : 1;
+    auto table = std::make_shared<std::vector<uint64_t>>(component.net.outputIds.size() * words, 0);
+    Net net = component.net;
+    enumerateTruthTable(net, [&](const TruthBlock& block) {
+        for (size_t o = 0; o < component.net.outputIds.size(); ++o) {
+            for (size_t w = 0; w < block.words && block.base / 64 + w < words; ++w) {
+                (*table)[o * words + block.base / 64 + w] = (*block.outs)[o * block.words + w];
+            }
+        }
+    });
+    component.lut = table;
+}
+
+void ComponentLibrary::buildFunction(const Component& component) {
+    functions_.erase(component.name);
+    if (component.net.cyclic) return;
+    try {
+        functions_[component.name] = buildBdds(*bdds_, component.net);
+    } catch (const std::exception&) {
+        // Too large for the node limit: the component just has no signature
+    }
+}
+
+std::vector<std::string> ComponentLibrary::findDuplicates(const std::string& name) const {
+    std::vector<std::string> result;
+    auto self = functions_.find(name);
+    if (self == functions_.end()) return result;
+    size_t inputs = components_.at(name).net.inputIds.size();
+    for (const auto& [other, f] : functions_) {
+        if (other != name && f == self->second && components_.at(other).net.inputIds.size() == inputs) {
+            result.push_back(other);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
 bool ComponentLibrary::loadComponents(const std::string& componentsDir) {
     components_.clear();
+    functions_.clear();
     
     if (!fs::exists(componentsDir)) {
         fs::create_directories(componentsDir);
@@ -163,9 +213,7 @@ bool ComponentLibrary::loadComponents(const std::string& componentsDir) {
             if (entry.is_regular_file() && entry.path().extension() == ".hdl") {
                 Component component;
                 if (parseComponentFile(entry.path().string(), component)) {
-                    if (validateComponent(component)) {
-                        components_[component.name] = component;
-                    }
+                    components_[component.name] = component;
                 }
             }
         }
@@ -173,6 +221,57 @@ bool ComponentLibrary::loadComponents(const std::string& componentsDir) {
         return false;
     }
     
+    // Drop invalid components; repeat since a removal can invalidate users
+    bool removed = true;
+    while (removed) {
+        removed = false;
+        for (auto it = components_.begin(); it != components_.end();) {
+            if (!validateComponent(it->second)) {
+                it = components_.erase(it);
+                removed = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+    
+    // Build nets dependencies-first so nested components can be flattened
+    std::unordered_map<std::string, int> state;  // 1 = building, 2 = done
+    std::vector<std::string> broken;
+    std::function<bool(const std::string&)> build = [&](const std::string& name) {
+        int& st = state[name];
+        if (st == 2) return true;
+        if (st == 1) return false;  // recursive component
+        st = 1;
+        Component& component = components_.at(name);
+        for (const auto& part : component.ast.parts) {
+            std::string kindLower = part.kind;
+            std::transform(kindLower.begin(), kindLower.end(), kindLower.begin(), ::tolower);
+            if (kindLower != "nand" && hasComponent(kindLower) && !build(kindLower)) return false;
+        }
+        try {
+            // Keep the component's own net at gate level so that callers
+            // building with BuildOptions::useLuts = false get plain gates
+            BuildOptions gatesOnly;
+            gatesOnly.useLuts = false;
+            component.net = buildNetWithComponents(component.ast, this, gatesOnly);
+            optimizeNet(component.net);
+            buildLut(component);
+            buildFunction(component);
+        } catch (const std::exception&) {
+            return false;
+        }
+        st = 2;
+        return true;
+    };
+    for (auto& [name, component] : components_) {
+        if (!build(name)) broken.push_back(name);
+    }
+    for (const auto& name : broken) {
+        components_.erase(name);
+        functions_.erase(name);
+    }
+    
     return true;
 }
 
@@ -221,6 +320,7 @@ bool ComponentLibrary::deleteComponent(const std::string& name, const std::strin
     if (fs::exists(filePath)) {
         fs::remove(filePath);
         components_.erase(name);
+        functions_.erase(name);
         return true;
     }
     
@@ -4,7 +4,9 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <memory>
 #include "simulator.h"
+#include "bdd.h"
 
 struct Component {
     std::string name;
@@ -14,6 +16,9 @@ struct Component {
     std::vector<std::string> outputs;
     AST ast;  // Parsed AST for the component
     Net net;  // Built net for simulation
+    // Packed truth table, one column of 2^inputs bits per output (see
+    // Net::LutInstance). Only set for small acyclic components.
+    std::shared_ptr<const std::vector<uint64_t>> lut;
     
     // Metadata
     std::string author;
@@ -47,8 +52,27 @@ public:
     // Get component directory path
     static std::string getComponentsDirectory();
     
+    // Components with at most this many inputs get a lookup table when
+    // loaded, so instances are evaluated by lookup instead of by their gates.
+    // Takes effect on the next loadComponents(); 0 disables tables.
+    static constexpr size_t kDefaultLutMaxInputs = 12;
+    static constexpr size_t kMaxLutInputs = 20;
+    void setLutMaxInputs(size_t maxInputs) { lutMaxInputs_ = maxInputs < kMaxLutInputs ? maxInputs : kMaxLutInputs; }
+    size_t getLutMaxInputs() const { return lutMaxInputs_; }
+    
+    // Other components computing the same function as name, with inputs
+    // and outputs matched by position. Each acyclic component's outputs are
+    // kept as BDDs in one manager, so this compares roots.
+    std::vector<std::string> findDuplicates(const std::string& name) const;
+    
 private:
     std::unordered_map<std::string, Component> components_;
+    size_t lutMaxInputs_ = kDefaultLutMaxInputs;
+    // Declared before functions_, whose handles must be released first
+    std::unique_ptr<BddManager> bdds_;
+    std::unordered_map<std::string, std::vector<Bdd>> functions_;
+    void buildLut(Component& component) const;
+    void buildFunction(const Component& component);
     bool parseComponentFile(const std::string& filePath, Component& component);
     bool validateComponent(const Component& component) const;
 };
@@ -0,0 +1,100 @@
+#include "cone_table.h"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+namespace {
+// Words simulated per run while building a table
+constexpr size_t kConeWords = 64;
+
+// Row bits output o depends on, ascending
+std::vector<uint32_t> supportBits(const Net& net, size_t o, const std::vector<uint32_t>& rowBit) {
+    std::vector<uint32_t> bits;
+    for (uint32_t i : net.outputSupport[o]) {
+        uint32_t b = rowBit.empty() ? i : rowBit[i];
+        if (b != Net::kNoSignal) bits.push_back(b);
+    }
+    std::sort(bits.begin(), bits.end());
+    bits.erase(std::unique(bits.begin(), bits.end()), bits.end());
+    if (!bits.empty() && bits.back() >= 63) throw std::runtime_error("Too many inputs to enumerate");
+    return bits;
+}
+
+std::map<std::vector<uint32_t>, std::vector<size_t>> groupBySupport(const Net& net,
+                                                                    const std::vector<uint32_t>& rowBit) {
+    std::map<std::vector<uint32_t>, std::vector<size_t>> groups;
+    for (size_t o = 0; o < net.outputIds.size(); ++o) groups[supportBits(net, o, rowBit)].push_back(o);
+    return groups;
+}
+}
+
+uint64_t coneRows(const Net& net, const std::vector<uint32_t>& rowBit) {
+    uint64_t rows = 0;
+    for (const auto& group : groupBySupport(net, rowBit)) {
+        uint64_t r = 1ull << group.first.size();
+        rows = rows > UINT64_MAX - r ? UINT64_MAX : rows + r;
+    }
+    return rows;
+}
+
+std::vector<ConeTable> buildConeTables(const Net& net, SimEngine engine, const std::vector<uint32_t>& rowBit) {
+    auto groups = groupBySupport(net, rowBit);
+    size_t widest = 0;
+    for (const auto& group : groups) widest = std::max(widest, group.first.size());
+    std::unique_ptr<WordSim> sim =
+        makeWordSim(net, engine, static_cast<size_t>(std::min<uint64_t>(kConeWords, ((1ull << widest) + 63) / 64)));
+    const size_t words = sim->words();
+
+    std::vector<ConeTable> tables(net.outputIds.size());
+    std::vector<std::vector<uint64_t>> cols;
+    for (const auto& [bits, outs] : groups) {
+        // Cone row r gives bits[j] the value of bit j of r
+        const size_t k = bits.size();
+        const uint64_t colWords = ((1ull << k) + 63) / 64;
+        std::vector<size_t> rank(net.inputIds.size(), SIZE_MAX);
+        for (size_t i = 0; i < rank.size(); ++i) {
+            uint32_t b = rowBit.empty() ? static_cast<uint32_t>(i) : rowBit[i];
+            auto it = std::lower_bound(bits.begin(), bits.end(), b);
+            if (it != bits.end() && *it == b) rank[i] = it - bits.begin();
+        }
+        cols.assign(outs.size(), std::vector<uint64_t>(colWords));
+        for (uint64_t w0 = 0; w0 < colWords; w0 += words) {
+            for (size_t i = 0; i < rank.size(); ++i) {
+                uint64_t* in = sim->input(i);
+                for (size_t w = 0; w < words; ++w) in[w] = rank[i] == SIZE_MAX ? 0 : WordSim::comboWord(rank[i], w0 + w);
+            }
+            sim->run();
+            size_t n = static_cast<size_t>(std::min<uint64_t>(words, colWords - w0));
+            for (size_t j = 0; j < outs.size(); ++j) std::copy_n(sim->output(outs[j]), n, cols[j].data() + w0);
+        }
+
+        // Lane l of a full-table word has row bits 0-5 equal to l; the
+        // support bits among them make up the low end of the cone row
+        size_t low = static_cast<size_t>(std::lower_bound(bits.begin(), bits.end(), 6u) - bits.begin());
+        uint64_t laneRow[64];
+        for (uint64_t l = 0; l < 64; ++l) {
+            laneRow[l] = 0;
+            for (size_t j = 0; j < low; ++j) laneRow[l] |= ((l >> bits[j]) & 1) << j;
+        }
+        for (size_t j = 0; j < outs.size(); ++j) {
+            ConeTable& t = tables[outs[j]];
+            for (size_t b = low; b < k; ++b) t.high_.push_back(bits[b] - 6);
+            std::vector<uint64_t>& col = cols[j];
+            if (low == 6) {
+                // Every lane bit is in the support: the cone's words are the lanes
+                t.lanes_.swap(col);
+                continue;
+            }
+            t.lanes_.assign(size_t{1} << (k - low), 0);
+            for (uint64_t h = 0; h < t.lanes_.size(); ++h) {
+                uint64_t x = 0;
+                for (uint64_t l = 0; l < 64; ++l) {
+                    uint64_t r = laneRow[l] | h << low;
+                    x |= ((col[r / 64] >> (r % 64)) & 1) << l;
+                }
+                t.lanes_[h] = x;
+            }
+        }
+    }
+    return tables;
+}
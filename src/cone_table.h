@@ -0,0 +1,38 @@
+#ifndef CONE_TABLE_H
+#define CONE_TABLE_H
+
+#include "bitsim.h"
+#include <cstdint>
+#include <vector>
+
+// One output's exhaustive column, simulated over its structural support
+// only (Net::outputSupport): 2^|support| rows instead of 2^n. word()
+// expands it back to the full column, in which row bit b is the value of
+// whichever input was assigned to it.
+class ConeTable {
+public:
+    // Word w of the full column (rows 64*w and up).
+    uint64_t word(uint64_t w) const {
+        size_t h = 0;
+        for (size_t j = 0; j < high_.size(); ++j) h |= static_cast<size_t>((w >> high_[j]) & 1) << j;
+        return lanes_[h];
+    }
+
+private:
+    friend std::vector<ConeTable> buildConeTables(const Net&, SimEngine, const std::vector<uint32_t>&);
+
+    std::vector<uint32_t> high_;   // support row bits above the lane bits, as bits of the word index
+    std::vector<uint64_t> lanes_;  // the 64 lanes of a word, per assignment of high_
+};
+
+// rowBit[i] is the row bit input i takes, or Net::kNoSignal for an input
+// held at 0; empty means input i is row bit i, as in InputVectors.
+
+// Rows buildConeTables() would simulate: 2^|support| summed over the
+// distinct supports of net's outputs (saturating).
+uint64_t coneRows(const Net& net, const std::vector<uint32_t>& rowBit = {});
+// One table per output of net, which must be acyclic. Outputs with the
+// same support share one simulation on engine.
+std::vector<ConeTable> buildConeTables(const Net& net, SimEngine engine, const std::vector<uint32_t>& rowBit = {});
+
+#endif
@@ -0,0 +1,155 @@
+#include "equivalence.h"
+#include "aig.h"
+#include "bdd.h"
+#include "sat.h"
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <stdexcept>
+
+namespace {
+// Random vectors simulated before the SAT call, in 64-lane words
+constexpr size_t kRandomWords = 4;
+
+size_t indexOf(const std::vector<std::string>& names, const std::string& name) {
+    return static_cast<size_t>(std::find(names.begin(), names.end(), name) - names.begin());
+}
+
+// Value of every AIG node for one input vector.
+std::vector<uint8_t> evalAig(const Aig& aig, const std::vector<int>& in) {
+    std::vector<uint8_t> v(aig.numNodes(), 0);
+    for (uint32_t i = 0; i < aig.numInputs; ++i) v[i + 1] = static_cast<uint8_t>(in[i] & 1);
+    auto litValue = [&](uint32_t l) { return static_cast<uint8_t>(v[Aig::node(l)] ^ (l & 1)); };
+    for (size_t k = 0; k < aig.numAnds(); ++k) {
+        v[aig.numInputs + 1 + k] = litValue(aig.fanin[2 * k]) & litValue(aig.fanin[2 * k + 1]);
+    }
+    return v;
+}
+}
+
+EquivalenceResult checkEquivalence(const Net& a, const Net& b, uint64_t conflictLimit, size_t bddNodeLimit) {
+    const std::vector<std::string>& ins = a.ast.inputs;
+    const std::vector<std::string>& outs = a.ast.outputs;
+    if (std::set<std::string>(ins.begin(), ins.end()) != std::set<std::string>(b.ast.inputs.begin(), b.ast.inputs.end())) {
+        throw std::runtime_error("Circuits have different inputs");
+    }
+    if (std::set<std::string>(outs.begin(), outs.end()) !=
+        std::set<std::string>(b.ast.outputs.begin(), b.ast.outputs.end())) {
+        throw std::runtime_error("Circuits have different outputs");
+    }
+    if (a.cyclic || b.cyclic) throw std::runtime_error("Equivalence checking needs circuits without feedback loops");
+
+    std::vector<uint32_t> aIns(ins.size()), bIns;
+    for (uint32_t i = 0; i < aIns.size(); ++i) aIns[i] = i;
+    for (const auto& name : b.ast.inputs) bIns.push_back(static_cast<uint32_t>(indexOf(ins, name)));
+    auto aig = std::make_shared<const Aig>(buildAig({&a, &b}, {aIns, bIns}, static_cast<uint32_t>(ins.size())));
+
+    // Output o of a and its namesake in b; structurally equal pairs are done
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    for (size_t o = 0; o < outs.size(); ++o) {
+        pairs.push_back({aig->outputs[o], aig->outputs[outs.size() + indexOf(b.ast.outputs, outs[o])]});
+    }
+
+    EquivalenceResult result;
+    auto refute = [&](std::vector<int> in) {
+        std::vector<uint8_t> v = evalAig(*aig, in);
+        result.counterexample = std::move(in);
+        for (size_t o = 0; o < pairs.size(); ++o) {
+            int x = v[Aig::node(pairs[o].first)] ^ (pairs[o].first & 1);
+            int y = v[Aig::node(pairs[o].second)] ^ (pairs[o].second & 1);
+            result.outA.push_back(x);
+            result.outB.push_back(y);
+            if (x != y) result.differing.push_back(outs[o]);
+        }
+        return result;
+    };
+
+    // Most wrong circuits are wrong on plenty of vectors
+    AigSim sim(aig, kRandomWords);
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < ins.size(); ++i) {
+        for (size_t w = 0; w < kRandomWords; ++w) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            sim.input(i)[w] = seed;
+        }
+    }
+    sim.run();
+    for (size_t w = 0; w < kRandomWords; ++w) {
+        uint64_t diff = 0;
+        for (size_t o = 0; o < pairs.size(); ++o) {
+            diff |= sim.output(o)[w] ^ sim.output(outs.size() + indexOf(b.ast.outputs, outs[o]))[w];
+        }
+        if (!diff) continue;
+        int lane = __builtin_ctzll(diff);
+        std::vector<int> in;
+        for (size_t i = 0; i < ins.size(); ++i) in.push_back(static_cast<int>((sim.input(i)[w] >> lane) & 1));
+        return refute(std::move(in));
+    }
+
+    // Canonical BDDs decide at once unless they blow up
+    if (bddNodeLimit) {
+        try {
+            BddManager mgr(aig->numInputs, bddNodeLimit);
+            std::vector<Bdd> f = buildBdds(mgr, *aig);
+            for (size_t o = 0; o < outs.size(); ++o) {
+                const Bdd& x = f[o];
+                const Bdd& y = f[outs.size() + indexOf(b.ast.outputs, outs[o])];
+                if (x != y) return refute(mgr.satisfyingAssignment(x ^ y));
+            }
+            result.equivalent = true;
+            return result;
+        } catch (const BddLimitError&) {
+        }
+    }
+
+    // Tseitin encoding of the ANDs in the differing outputs' cones: AIG
+    // node n is variable n, so AIG literals are solver literals
+    std::vector<uint8_t> cone(aig->numNodes(), 0);
+    for (const auto& [x, y] : pairs) {
+        if (x == y) continue;
+        cone[Aig::node(x)] = cone[Aig::node(y)] = 1;
+    }
+    SatSolver solver;
+    for (size_t n = 0; n < aig->numNodes(); ++n) solver.newVar();
+    solver.addClause({SatSolver::lit(0, true)});
+    const uint32_t firstAnd = aig->numInputs + 1;
+    for (size_t k = aig->numAnds(); k-- > 0;) {
+        uint32_t n = firstAnd + static_cast<uint32_t>(k);
+        if (!cone[n]) continue;
+        uint32_t x = aig->fanin[2 * k], y = aig->fanin[2 * k + 1];
+        cone[Aig::node(x)] = cone[Aig::node(y)] = 1;
+        solver.addClause({SatSolver::lit(n, true), x});
+        solver.addClause({SatSolver::lit(n, true), y});
+        solver.addClause({SatSolver::lit(n), x ^ 1, y ^ 1});
+    }
+    // The miter: some pair differs
+    std::vector<uint32_t> any;
+    for (const auto& [x, y] : pairs) {
+        if (x == y) continue;
+        uint32_t d = solver.newVar();
+        solver.addClause({SatSolver::lit(d, true), x, y});
+        solver.addClause({SatSolver::lit(d, true), x ^ 1, y ^ 1});
+        any.push_back(SatSolver::lit(d));
+    }
+    if (any.empty()) {
+        result.equivalent = true;
+        return result;
+    }
+    solver.addClause(any);
+
+    switch (solver.solve(conflictLimit)) {
+        case SatSolver::Result::Unsat:
+            result.equivalent = true;
+            return result;
+        case SatSolver::Result::Sat: {
+            std::vector<int> in;
+            for (uint32_t i = 0; i < aig->numInputs; ++i) in.push_back(solver.value(i + 1));
+            return refute(std::move(in));
+        }
+        default:
+            throw std::runtime_error("Equivalence check gave up after " + std::to_string(solver.conflicts()) +
+                                     " conflicts");
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef EQUIVALENCE_H
+#define EQUIVALENCE_H
+
+#include "simulator.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct EquivalenceResult {
+    bool equivalent = false;
+    // When not equivalent: an input vector they disagree on, one value per
+    // input of a, and both nets' outputs there, in a's output order
+    std::vector<int> counterexample;
+    std::vector<int> outA, outB;
+    std::vector<std::string> differing;  // outputs whose values differ
+};
+
+// BDD nodes a check may use before handing over to the SAT solver
+constexpr size_t kEquivalenceBddNodes = size_t{1} << 20;
+
+// Proves that nets a and b compute the same function, with ports matched
+// by name. Both are lowered into one AIG whose paired outputs are XORed
+// (a miter); a few words of random vectors look for a cheap
+// counterexample. Then both sides' BDDs are built, which settles the
+// question by comparing roots. Should that take more than bddNodeLimit
+// nodes (0 skips BDDs), the miter's Tseitin encoding goes to SatSolver
+// and is equivalent exactly when unsatisfiable. Throws if the port sets
+// differ, for nets with feedback loops, and if conflictLimit (0 = none)
+// runs out before an answer.
+EquivalenceResult checkEquivalence(const Net& a, const Net& b, uint64_t conflictLimit = 0,
+                                   size_t bddNodeLimit = kEquivalenceBddNodes);
+
+#endif
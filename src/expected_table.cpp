@@ -0,0 +1,275 @@
+#include "expected_table.h"
+#include "truth_file.h"
+#include "gate_kernels.h"
+#include "cone_table.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+// Input i (< 6) across the 64 rows of a word
+constexpr uint64_t kRowPattern[6] = {
+    0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+    0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull,
+};
+
+uint64_t tailMask(uint64_t cases) {
+    return cases % 64 ? (1ull << (cases % 64)) - 1 : ~0ull;
+}
+
+uint64_t exhaustiveRows(size_t inputs) {
+    if (inputs >= 64) throw std::runtime_error("Too many inputs to enumerate: " + std::to_string(inputs));
+    return 1ull << inputs;
+}
+
+// Column of a hex number whose bit r is row r; the last digit holds rows 0-3.
+std::vector<uint64_t> decodeHex(const std::string& hex, uint64_t rows, const std::string& port) {
+    std::vector<uint64_t> col((rows + 63) / 64, 0);
+    uint64_t r = 0;
+    for (auto it = hex.rbegin(); it != hex.rend(); ++it, r += 4) {
+        char ch = *it;
+        uint64_t d;
+        if (ch >= '0' && ch <= '9') d = ch - '0';
+        else if (ch >= 'a' && ch <= 'f') d = ch - 'a' + 10;
+        else if (ch >= 'A' && ch <= 'F') d = ch - 'A' + 10;
+        else throw std::runtime_error("Bad hex digit in truth table of " + port);
+        if (d == 0) continue;
+        if (r >= rows || (rows - r < 4 && d >> (rows - r))) {
+            throw std::runtime_error("Truth table of " + port + " has rows past the last input combination");
+        }
+        col[r / 64] |= d << (r % 64);
+    }
+    return col;
+}
+}
+
+ExpectedTable::ExpectedTable(std::vector<std::string> ins, std::vector<std::string> outs)
+    : inputs(std::move(ins)), outputs(std::move(outs)),
+      in_(inputs.size()), out_(outputs.size()), care_(outputs.size()) {}
+
+ExpectedTable ExpectedTable::fromHex(std::vector<std::string> ins, std::vector<std::string> outs,
+                                     const std::vector<std::string>& hex, const std::vector<std::string>& dontCare) {
+    ExpectedTable t(std::move(ins), std::move(outs));
+    t.exhaustive = true;
+    t.cases = exhaustiveRows(t.inputs.size());
+    t.in_.clear();
+    for (size_t o = 0; o < t.outputs.size(); ++o) {
+        t.out_[o] = decodeHex(hex[o], t.cases, t.outputs[o]);
+        if (dontCare.empty()) continue;
+        t.care_[o] = decodeHex(dontCare[o], t.cases, t.outputs[o]);
+        for (size_t w = 0; w < t.care_[o].size(); ++w) t.care_[o][w] = ~t.care_[o][w];
+        t.care_[o].back() &= tailMask(t.cases);
+    }
+    return t;
+}
+
+ExpectedTable ExpectedTable::fromFile(std::vector<std::string> ins, std::vector<std::string> outs,
+                                      const std::string& path, const std::string& dontCarePath) {
+    ExpectedTable t(std::move(ins), std::move(outs));
+    t.exhaustive = true;
+    t.cases = exhaustiveRows(t.inputs.size());
+    t.in_.clear();
+
+    auto file = std::make_shared<TruthFile>(path);
+    std::shared_ptr<TruthFile> dcFile;
+    if (!dontCarePath.empty()) dcFile = std::make_shared<TruthFile>(dontCarePath);
+    auto columns = [&](const TruthFile& f, const std::string& name, bool optional) -> std::vector<const uint64_t*> {
+        if (f.inputs() != t.inputs) throw std::runtime_error(name + " does not have the level's inputs, in order");
+        std::vector<const uint64_t*> cols;
+        for (const auto& port : t.outputs) {
+            auto it = std::find(f.outputs().begin(), f.outputs().end(), port);
+            if (it == f.outputs().end() && !optional) throw std::runtime_error(name + " lacks output " + port);
+            cols.push_back(it == f.outputs().end() ? nullptr : f.column(it - f.outputs().begin()));
+        }
+        return cols;
+    };
+    t.outView_ = columns(*file, path, false);
+    std::vector<const uint64_t*> dc;
+    if (dcFile) dc = columns(*dcFile, dontCarePath, true);
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    // Files are little-endian; keep swapped copies rather than views
+    for (size_t o = 0; o < t.outputs.size(); ++o) {
+        t.out_[o].assign(t.outView_[o], t.outView_[o] + t.words());
+        for (auto& x : t.out_[o]) x = __builtin_bswap64(x);
+        if (!dc.empty() && dc[o]) {
+            t.care_[o].assign(dc[o], dc[o] + t.words());
+            for (auto& x : t.care_[o]) x = ~__builtin_bswap64(x);
+            t.care_[o].back() &= tailMask(t.cases);
+        }
+    }
+    t.outView_.clear();
+    return t;
+#else
+    // Don't-care files hold the complement of the care mask, so those
+    // columns are inverted into owned memory
+    for (size_t o = 0; o < dc.size(); ++o) {
+        if (!dc[o]) continue;
+        t.care_[o].assign(dc[o], dc[o] + t.words());
+        for (auto& x : t.care_[o]) x = ~x;
+        t.care_[o].back() &= tailMask(t.cases);
+    }
+    t.owner_ = file;
+    return t;
+#endif
+}
+
+void ExpectedTable::addCase(const Values& inVals, const Values& outVals) {
+    if (cases % 64 == 0) {
+        for (auto* cols : {&in_, &out_, &care_}) {
+            for (auto& col : *cols) col.push_back(0);
+        }
+    }
+    // A port first named by this case gets a column, empty so far
+    auto column = [&](std::vector<std::string>& ports, std::vector<std::vector<uint64_t>>& cols,
+                      const std::string& name) {
+        auto it = std::find(ports.begin(), ports.end(), name);
+        if (it != ports.end()) return static_cast<size_t>(it - ports.begin());
+        ports.push_back(name);
+        cols.emplace_back(cases / 64 + 1, 0);
+        if (&cols == &out_) care_.emplace_back(cases / 64 + 1, 0);
+        return ports.size() - 1;
+    };
+    uint64_t bit = 1ull << (cases % 64);
+    size_t w = cases / 64;
+    for (const auto& [name, v] : inVals) {
+        size_t i = column(inputs, in_, name);
+        if (v & 1) in_[i][w] |= bit;
+    }
+    for (const auto& [name, v] : outVals) {
+        size_t o = column(outputs, out_, name);
+        care_[o][w] |= bit;
+        if (v) out_[o][w] |= bit;
+    }
+    ++cases;
+}
+
+uint64_t ExpectedTable::inputWord(size_t i, size_t w) const {
+    if (!exhaustive) return in_[i][w];
+    if (i < 6) return kRowPattern[i];
+    return (static_cast<uint64_t>(w) >> (i - 6)) & 1 ? ~0ull : 0;
+}
+
+uint64_t ExpectedTable::careWord(size_t o, size_t w) const {
+    if (!care_[o].empty()) return care_[o][w];
+    return w + 1 == words() ? tailMask(cases) : ~0ull;
+}
+
+MismatchTally checkTable(Net& net, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs,
+                         const ExpectedTable& table, SimEngine engine, size_t maxFailures, bool stopAtFirst) {
+    MismatchTally tally;
+    tally.perOutput.assign(table.outputs.size(), 0);
+    std::vector<size_t> inCol, outIndex;
+    for (const auto& name : inputs) {
+        auto it = std::find(table.inputs.begin(), table.inputs.end(), name);
+        inCol.push_back(it == table.inputs.end() ? SIZE_MAX : it - table.inputs.begin());
+    }
+    for (const auto& name : table.outputs) {
+        auto it = std::find(outputs.begin(), outputs.end(), name);
+        outIndex.push_back(it == outputs.end() ? SIZE_MAX : it - outputs.begin());
+    }
+
+    if (!BitSim::supports(net)) {
+        // Feedback loops: step cases in order so latch state carries over,
+        // re-evaluating only what each case's input changes disturb. The
+        // caller's mode is restored afterwards.
+        SimMode mode = net.mode;
+        net.mode = SimMode::EventDriven;
+        std::vector<uint8_t> in(inputs.size()), out(outputs.size());
+        for (size_t c = 0; c < table.cases; ++c) {
+            for (size_t i = 0; i < in.size(); ++i) in[i] = inCol[i] != SIZE_MAX && table.inputBit(inCol[i], c);
+            simulate(net, in.data(), out.data());
+            bool failed = false;
+            for (size_t o = 0; o < table.outputs.size(); ++o) {
+                if (!table.cares(o, c)) continue;
+                if (outIndex[o] != SIZE_MAX && out[outIndex[o]] == table.outputBit(o, c)) continue;
+                ++tally.perOutput[o];
+                failed = true;
+            }
+            if (!failed) continue;
+            ++tally.failedCases;
+            if (tally.failures.size() < maxFailures) {
+                MismatchTally::Failure f{c, {}};
+                for (size_t o = 0; o < table.outputs.size(); ++o) {
+                    f.got.push_back(outIndex[o] == SIZE_MAX ? -1 : out[outIndex[o]]);
+                }
+                tally.failures.push_back(std::move(f));
+            }
+            if (stopAtFirst) break;
+        }
+        net.mode = mode;
+        return tally;
+    }
+
+    const GateKernels& k = gateKernels();
+    const size_t words = table.words();
+    const size_t chunk = std::max<size_t>(1, std::min(words, kCheckChunkWords));
+
+    // An exhaustive table's input columns are its row bits, so outputs that
+    // read few inputs can be simulated over those alone (cone_table.h)
+    std::vector<ConeTable> cones;
+    if (table.exhaustive && !outputs.empty()) {
+        std::vector<uint32_t> rowBit;
+        for (size_t c : inCol) rowBit.push_back(c == SIZE_MAX ? Net::kNoSignal : static_cast<uint32_t>(c));
+        if (coneRows(net, rowBit) < table.cases) cones = buildConeTables(net, engine, rowBit);
+    }
+    std::unique_ptr<WordSim> sim = cones.empty() ? makeWordSim(net, engine, chunk) : nullptr;
+    std::vector<std::vector<uint64_t>> expanded(cones.size(), std::vector<uint64_t>(chunk));
+    auto solution = [&](size_t out) { return sim ? sim->output(out) : expanded[out].data(); };
+
+    std::vector<uint64_t> bad(chunk);
+    for (size_t w0 = 0; w0 < words; w0 += chunk) {
+        size_t n = std::min(chunk, words - w0);
+        if (sim) {
+            for (size_t i = 0; i < inCol.size(); ++i) {
+                uint64_t* col = sim->input(i);
+                for (size_t w = 0; w < n; ++w) col[w] = inCol[i] == SIZE_MAX ? 0 : table.inputWord(inCol[i], w0 + w);
+            }
+            sim->run();
+        } else {
+            for (size_t o : outIndex) {
+                if (o == SIZE_MAX) continue;
+                for (size_t w = 0; w < n; ++w) expanded[o][w] = cones[o].word(w0 + w);
+            }
+        }
+
+        // bad collects, per word, the cases that fail on any output
+        std::fill(bad.begin(), bad.begin() + n, 0);
+        for (size_t o = 0; o < table.outputs.size(); ++o) {
+            const uint64_t* mask = table.mask(o);
+            if (outIndex[o] == SIZE_MAX) {
+                for (size_t w = 0; w < n; ++w) {
+                    uint64_t m = table.careWord(o, w0 + w);
+                    bad[w] |= m;
+                    tally.perOutput[o] += static_cast<uint64_t>(__builtin_popcountll(m));
+                }
+                continue;
+            }
+            // Without a mask the kernel counts every lane, so a partial last
+            // word is left to careWord()
+            size_t full = !mask && w0 + n == words && table.cases % 64 ? n - 1 : n;
+            const uint64_t* got = solution(outIndex[o]);
+            tally.perOutput[o] += k.diffCount(bad.data(), got, table.output(o) + w0, mask ? mask + w0 : nullptr, full);
+            if (full < n) {
+                uint64_t d = (got[full] ^ table.output(o)[w0 + full]) & table.careWord(o, w0 + full);
+                bad[full] |= d;
+                tally.perOutput[o] += static_cast<uint64_t>(__builtin_popcountll(d));
+            }
+        }
+        uint64_t failed = k.popcount(bad.data(), n);
+        if (failed == 0) continue;
+        tally.failedCases += failed;
+        for (size_t w = 0; w < n && tally.failures.size() < maxFailures; ++w) {
+            for (uint64_t b = bad[w]; b && tally.failures.size() < maxFailures; b &= b - 1) {
+                size_t lane = static_cast<size_t>(__builtin_ctzll(b));
+                MismatchTally::Failure f{64 * (w0 + w) + lane, {}};
+                for (size_t o = 0; o < table.outputs.size(); ++o) {
+                    if (outIndex[o] == SIZE_MAX) f.got.push_back(-1);
+                    else f.got.push_back(static_cast<int>((solution(outIndex[o])[w] >> lane) & 1));
+                }
+                tally.failures.push_back(std::move(f));
+            }
+        }
+        if (stopAtFirst) break;
+    }
+    return tally;
+}
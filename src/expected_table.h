@@ -0,0 +1,95 @@
+#ifndef EXPECTED_TABLE_H
+#define EXPECTED_TABLE_H
+
+#include "bitsim.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A level's expected truth table as bit columns: case c is bit c % 64 of
+// word c / 64 in every column. The level's declared ports come first, in
+// order; ports that only its cases name follow.
+//
+// Tables listing every input combination are exhaustive: case c is row c
+// of InputVectors, so input i is bit i of c and no input columns are kept.
+// Their output columns may live in a memory-mapped file.
+class ExpectedTable {
+public:
+    using Values = std::vector<std::pair<std::string, int>>;
+
+    std::vector<std::string> inputs, outputs;  // port order of the columns
+    size_t cases = 0;
+    bool exhaustive = false;
+
+    ExpectedTable() = default;
+    // An empty table to fill with addCase().
+    ExpectedTable(std::vector<std::string> inputs, std::vector<std::string> outputs);
+
+    // Exhaustive table from hex numbers whose bit r is row r, one per output
+    // (most significant digit first). dontCare is empty or holds a number
+    // per output whose set bits are rows that output need not match.
+    // Throws on malformed digits or bits past the last row.
+    static ExpectedTable fromHex(std::vector<std::string> inputs, std::vector<std::string> outputs,
+                                 const std::vector<std::string>& hex, const std::vector<std::string>& dontCare);
+    // Exhaustive table backed by a truth-table file (truth_file.h), which
+    // stays mapped while any copy of the table is alive. The file's inputs
+    // must be exactly `inputs`, in order, and it must have every output;
+    // dontCarePath, if given, is a file of the same shape whose set bits are
+    // don't-cares. Throws otherwise.
+    static ExpectedTable fromFile(std::vector<std::string> inputs, std::vector<std::string> outputs,
+                                  const std::string& path, const std::string& dontCarePath = "");
+
+    // Appends a case. Inputs it leaves out read as 0; outputs it leaves out
+    // are don't-cares for it. Not for exhaustive tables.
+    void addCase(const Values& inVals, const Values& outVals);
+
+    size_t words() const { return (cases + 63) / 64; }
+    uint64_t inputWord(size_t i, size_t w) const;
+    const uint64_t* output(size_t o) const { return owner_ ? outView_[o] : out_[o].data(); }
+    // Cases output o must match in word w; zero past the last case.
+    uint64_t careWord(size_t o, size_t w) const;
+    // Care column of output o, or nullptr when the table specifies it for
+    // every case (and only careWord() knows where the cases end).
+    const uint64_t* mask(size_t o) const { return care_[o].empty() ? nullptr : care_[o].data(); }
+
+    int inputBit(size_t i, size_t c) const { return static_cast<int>((inputWord(i, c / 64) >> (c % 64)) & 1); }
+    int outputBit(size_t o, size_t c) const { return static_cast<int>((output(o)[c / 64] >> (c % 64)) & 1); }
+    bool cares(size_t o, size_t c) const { return (careWord(o, c / 64) >> (c % 64)) & 1; }
+
+private:
+    // Owned columns; care_[o] is empty when output o is specified everywhere
+    std::vector<std::vector<uint64_t>> in_, out_, care_;
+    // Output columns inside a mapped file, used instead of out_ when owner_ is set
+    std::vector<const uint64_t*> outView_;
+    std::shared_ptr<const void> owner_;
+};
+
+// Where a solution disagrees with a table.
+struct MismatchTally {
+    struct Failure {
+        uint64_t c;            // case number
+        std::vector<int> got;  // solution's value per table output, -1 if it lacks that output
+    };
+    uint64_t failedCases = 0;         // cases with at least one wrong output
+    std::vector<uint64_t> perOutput;  // wrong cases per table output
+    std::vector<Failure> failures;    // the first failing cases, in order
+};
+
+// Cases simulated per word-parallel run in checkTable.
+constexpr size_t kCheckChunkWords = 64;
+
+// Simulates net, whose ports are named inputs and outputs, on every case
+// of table and tallies the cases it gets wrong, keeping up to maxFailures
+// of them. Acyclic nets run kCheckChunkWords at a time on engine and
+// differences are counted with the gate kernels' popcount. On exhaustive
+// tables, outputs whose supports need fewer rows than the table are
+// simulated over their supports only (cone_table.h). Nets with feedback
+// loops step through the cases in order, event-driven whatever net.mode
+// says, and keep the latch state of the last case. With stopAtFirst the
+// tally stops after the chunk (or case) holding the first failure.
+MismatchTally checkTable(Net& net, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs,
+                         const ExpectedTable& table, SimEngine engine, size_t maxFailures, bool stopAtFirst = false);
+
+#endif
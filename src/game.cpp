@@ -1,5 +1,7 @@
 #include "game.h"
 #include "simulator.h"
+#include "bitsim.h"
+#include "net_optimizer.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -9,6 +11,7 @@
 #include <cctype>
 #include <set>
 #include <iomanip>
+#include <stdexcept>
 
 namespace fs = std::filesystem;
 
@@ -57,16 +60,53 @@ static std::vector<std::string> extractJsonArray(const std::string& json, const
     return result;
 }
 
-static std::vector<std::unordered_map<std::string, std::unordered_map<std::string, int>>> 
-extractExpected(const std::string& json) {
-    std::vector<std::unordered_map<std::string, std::unordered_map<std::string, int>>> result;
-    
+// Reads {"name": "value", ...} under key. Scanned by hand rather than with
+// std::regex, since the values can be megabytes of hex.
+static std::vector<std::pair<std::string, std::string>> extractJsonStringMap(const std::string& json,
+                                                                             const std::string& key) {
+    std::vector<std::pair<std::string, std::string>> result;
+    size_t pos = json.find("\"" + key + "\"");
+    if (pos == std::string::npos) return result;
+    pos += key.size() + 2;
+    auto skipSpace = [&]() {
+        while (pos < json.size() && std::isspace(static_cast<unsigned char>(json[pos]))) ++pos;
+    };
+    auto expect = [&](char c) {
+        skipSpace();
+        if (pos >= json.size() || json[pos] != c) throw std::runtime_error("Malformed \"" + key + "\" object");
+        ++pos;
+    };
+    auto quoted = [&]() {
+        expect('"');
+        size_t end = json.find('"', pos);
+        if (end == std::string::npos) throw std::runtime_error("Malformed \"" + key + "\" object");
+        std::string text = json.substr(pos, end - pos);
+        pos = end + 1;
+        return text;
+    };
+    expect(':');
+    expect('{');
+    skipSpace();
+    while (pos < json.size() && json[pos] != '}') {
+        std::string name = quoted();
+        expect(':');
+        result.emplace_back(name, quoted());
+        skipSpace();
+        if (pos < json.size() && json[pos] == ',') ++pos;
+        skipSpace();
+    }
+    expect('}');
+    return result;
+}
+
+// Reads the "expected" array into result, whose declared ports are set.
+static void extractExpected(const std::string& json, ExpectedTable& result) {
     // Find the "expected" array - match from "expected": [ to matching ]
     size_t expectedPos = json.find("\"expected\"");
-    if (expectedPos == std::string::npos) return result;
+    if (expectedPos == std::string::npos) return;
     
     size_t arrayStart = json.find('[', expectedPos);
-    if (arrayStart == std::string::npos) return result;
+    if (arrayStart == std::string::npos) return;
     
     // Find matching closing bracket
     int depth = 1;
@@ -75,7 +115,7 @@ extractExpected(const std::string& json) {
         if (json[arrayEnd] == '[') depth++;
         else if (json[arrayEnd] == ']') depth--;
     }
-    if (depth != 0) return result;
+    if (depth != 0) return;
     
     std::string expectedStr = json.substr(arrayStart + 1, arrayEnd - arrayStart - 2);
     
@@ -103,8 +143,7 @@ extractExpected(const std::string& json) {
         std::smatch inMatch, outMatch;
         
         if (std::regex_search(caseStr, inMatch, inRe) && std::regex_search(caseStr, outMatch, outRe)) {
-            std::unordered_map<std::string, std::unordered_map<std::string, int>> testCase;
-            std::unordered_map<std::string, int> inMap, outMap;
+            ExpectedTable::Values inVals, outVals;
             
             // Parse "in" map
             std::string inStr = inMatch[1];
@@ -112,7 +151,7 @@ extractExpected(const std::string& json) {
             std::sregex_iterator inIter(inStr.begin(), inStr.end(), pairRe);
             std::sregex_iterator inEnd;
             for (; inIter != inEnd; ++inIter) {
-                inMap[(*inIter)[1]] = std::stoi((*inIter)[2]);
+                inVals.emplace_back((*inIter)[1], std::stoi((*inIter)[2]));
             }
             
             // Parse "out" map
@@ -120,18 +159,14 @@ extractExpected(const std::string& json) {
             std::sregex_iterator outIter(outStr.begin(), outStr.end(), pairRe);
             std::sregex_iterator outEnd;
             for (; outIter != outEnd; ++outIter) {
-                outMap[(*outIter)[1]] = std::stoi((*outIter)[2]);
+                outVals.emplace_back((*outIter)[1], std::stoi((*outIter)[2]));
             }
             
-            testCase["in"] = inMap;
-            testCase["out"] = outMap;
-            result.push_back(testCase);
+            result.addCase(inVals, outVals);
         }
         
         pos = caseEnd;
     }
-    
-    return result;
 }
 
 Game::Game() {
@@ -140,7 +175,7 @@ Game::Game() {
     componentLibrary_.loadComponents(componentsDir);
 }
 
-bool Game::parseLevelJson(const std::string& jsonContent, Level& level) {
+bool Game::parseLevelJson(const std::string& jsonContent, Level& level, const std::string& levelDir) {
     level.id = extractJsonString(jsonContent, "id");
     level.name = extractJsonString(jsonContent, "name");
     level.description = extractJsonString(jsonContent, "description");
@@ -148,7 +183,51 @@ bool Game::parseLevelJson(const std::string& jsonContent, Level& level) {
     level.available_gates = extractJsonArray(jsonContent, "available_gates");
     level.inputs = extractJsonArray(jsonContent, "inputs");
     level.outputs = extractJsonArray(jsonContent, "outputs");
-    level.expected = extractExpected(jsonContent);
+    
+    // Expected outputs come from a truth-table sidecar, hex columns inline,
+    // or the "expected" array of cases, in that order of preference
+    try {
+        if (jsonContent.find("\"truth_table_file\"") != std::string::npos) {
+            std::string file = extractJsonString(jsonContent, "truth_table_file");
+            std::string dontCare = extractJsonString(jsonContent, "dont_care_file");
+            level.expected = ExpectedTable::fromFile(level.inputs, level.outputs, (fs::path(levelDir) / file).string(),
+                                                     dontCare.empty() ? "" : (fs::path(levelDir) / dontCare).string());
+        } else if (jsonContent.find("\"truth_table\"") != std::string::npos) {
+            auto columns = extractJsonStringMap(jsonContent, "truth_table");
+            auto dontCareColumns = extractJsonStringMap(jsonContent, "dont_care");
+            auto lookup = [](const std::vector<std::pair<std::string, std::string>>& cols, const std::string& port) {
+                for (const auto& kv : cols) {
+                    if (kv.first == port) return kv.second;
+                }
+                return std::string();
+            };
+            std::vector<std::string> hex, dontCare;
+            for (const auto& port : level.outputs) {
+                hex.push_back(lookup(columns, port));
+                if (hex.back().empty()) return false;
+                if (!dontCareColumns.empty()) dontCare.push_back(lookup(dontCareColumns, port));
+            }
+            level.expected = ExpectedTable::fromHex(level.inputs, level.outputs, hex, dontCare);
+        } else {
+            level.expected = ExpectedTable(level.inputs, level.outputs);
+            extractExpected(jsonContent, level.expected);
+        }
+        // A reference circuit must have exactly the level's ports
+        std::string reference = extractJsonString(jsonContent, "reference_file");
+        if (!reference.empty()) {
+            level.reference = readFile((fs::path(levelDir) / reference).string());
+            if (level.reference.empty()) return false;
+            AST ast = parseHDL(level.reference);
+            if (std::set<std::string>(ast.inputs.begin(), ast.inputs.end()) !=
+                    std::set<std::string>(level.inputs.begin(), level.inputs.end()) ||
+                std::set<std::string>(ast.outputs.begin(), ast.outputs.end()) !=
+                    std::set<std::string>(level.outputs.begin(), level.outputs.end())) {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
     
     return !level.id.empty() && !level.name.empty();
 }
@@ -164,8 +243,8 @@ bool Game::loadLevels(const std::string& levelsDir) {
         if (entry.is_regular_file() && entry.path().extension() == ".json") {
             std::string content = readFile(entry.path().string());
             Level level;
-            if (parseLevelJson(content, level)) {
-                levels_.push_back(level);
+            if (parseLevelJson(content, level, entry.path().parent_path().string())) {
+                levels_.push_back(std::move(level));
             }
         }
     }
@@ -190,6 +269,7 @@ bool Game::validateSolution(const Level& level, const std::string& hdlContent) {
     try {
         AST ast = parseHDL(hdlContent);
         Net net = buildNetWithComponents(ast, &componentLibrary_);
+        optimizeNet(net);
         
         // Check inputs match
         std::set<std::string> userInputs(ast.inputs.begin(), ast.inputs.end());
@@ -211,26 +291,26 @@ bool Game::validateSolution(const Level& level, const std::string& hdlContent) {
             }
         }
         
-        // Validate against expected truth table
-        for (const auto& testCase : level.expected) {
-            const auto& inVec = testCase.at("in");
-            const auto& expectedOut = testCase.at("out");
-            
-            auto actualOut = simulate(net, inVec);
-            
-            for (const auto& [key, expectedVal] : expectedOut) {
-                if (actualOut.find(key) == actualOut.end() || actualOut.at(key) != expectedVal) {
-                    return false;
-                }
-            }
+        // Levels without a table are checked by proof against their reference
+        if (level.expected.cases == 0 && !level.reference.empty()) {
+            return compareWithReference(level, net).equivalent;
         }
-        
-        return true;
+
+        // Validate against expected truth table; a wrong solution stops at
+        // the chunk holding its first failing case
+        return checkTable(net, ast.inputs, ast.outputs, level.expected, simEngine_, 0, true).failedCases == 0;
     } catch (...) {
         return false;
     }
 }
 
+EquivalenceResult Game::compareWithReference(const Level& level, const Net& solution) {
+    if (level.reference.empty()) throw std::runtime_error("Level " + level.id + " has no reference circuit");
+    Net reference = buildNetWithComponents(parseHDL(level.reference), &componentLibrary_);
+    optimizeNet(reference);
+    return checkEquivalence(solution, reference);
+}
+
 void Game::markCompleted(const std::string& levelId) {
     completed_.insert(levelId);
 }
@@ -6,6 +6,9 @@
 #include <unordered_map>
 #include <unordered_set>
 #include "component_library.h"
+#include "bitsim.h"
+#include "expected_table.h"
+#include "equivalence.h"
 
 struct Level {
     std::string id;
@@ -15,16 +18,22 @@ struct Level {
     std::vector<std::string> available_gates;
     std::vector<std::string> inputs;
     std::vector<std::string> outputs;
-    std::vector<std::unordered_map<std::string, std::unordered_map<std::string, int>>> expected;
+    ExpectedTable expected;  // no cases: component design mode, unless there is a reference
+    // HDL of a reference solution. Levels too wide for a truth table give
+    // one instead, and solutions are proved equivalent to it.
+    std::string reference;
 };
 
 class Game {
 public:
     Game();
     bool loadLevels(const std::string& levelsDir);
-    std::vector<Level> getLevels() const { return levels_; }
+    const std::vector<Level>& getLevels() const { return levels_; }
     Level* getLevel(const std::string& id);
     bool validateSolution(const Level& level, const std::string& hdlContent);
+    // Equivalence of a built solution with the level's reference circuit.
+    // Throws if the level has none or either circuit has feedback loops.
+    EquivalenceResult compareWithReference(const Level& level, const Net& solution);
     void markCompleted(const std::string& levelId);
     bool isCompleted(const std::string& levelId) const;
     void loadProgress(const std::string& progressFile);
@@ -33,13 +42,18 @@ public:
     std::string loadSolution(const std::string& levelId) const;
     ComponentLibrary& getComponentLibrary() { return componentLibrary_; }
     const ComponentLibrary& getComponentLibrary() const { return componentLibrary_; }
+    // Word-parallel engine validateSolution uses for acyclic solutions
+    void setSimEngine(SimEngine engine) { simEngine_ = engine; }
+    SimEngine getSimEngine() const { return simEngine_; }
     
 private:
     std::vector<Level> levels_;
     std::unordered_set<std::string> completed_;
     std::unordered_map<std::string, std::string> savedSolutions_; // levelId -> solution
     ComponentLibrary componentLibrary_;
-    bool parseLevelJson(const std::string& jsonContent, Level& level);
+    SimEngine simEngine_ = SimEngine::Netlist;
+    // levelDir resolves the "truth_table_file" and "reference_file" sidecars named by the level
+    bool parseLevelJson(const std::string& jsonContent, Level& level, const std::string& levelDir = ".");
     std::string readFile(const std::string& path);
 };
 
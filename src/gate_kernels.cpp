@@ -0,0 +1,188 @@
+#include "gate_kernels.h"
+#include <cstdlib>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MINLAB_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// Portable fallback. Plain loops; the compiler may still vectorize them
+// for the baseline ISA.
+namespace scalar {
+static void notOp(uint64_t* o, const uint64_t* a, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = ~a[i]; }
+static void andOp(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = a[i] & b[i]; }
+static void orOp(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = a[i] | b[i]; }
+static void xorOp(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = a[i] ^ b[i]; }
+static void nandOp(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = ~(a[i] & b[i]); }
+static void norOp(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n) { for (size_t i = 0; i < n; ++i) o[i] = ~(a[i] | b[i]); }
+static uint64_t popcount(const uint64_t* a, size_t n) {
+    uint64_t c = 0;
+    for (size_t i = 0; i < n; ++i) c += static_cast<uint64_t>(__builtin_popcountll(a[i]));
+    return c;
+}
+static uint64_t diffCount(uint64_t* acc, const uint64_t* a, const uint64_t* b, const uint64_t* mask, size_t n) {
+    uint64_t c = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t d = (a[i] ^ b[i]) & (mask ? mask[i] : ~0ull);
+        acc[i] |= d;
+        c += static_cast<uint64_t>(__builtin_popcountll(d));
+    }
+    return c;
+}
+}
+
+static const GateKernels kScalar = {
+    "scalar", scalar::notOp, scalar::andOp, scalar::orOp, scalar::xorOp, scalar::nandOp, scalar::norOp,
+    scalar::popcount, scalar::diffCount,
+};
+
+#ifdef MINLAB_X86_KERNELS
+namespace avx2 {
+#define MINLAB_AVX2 __attribute__((target("avx2")))
+// Vector body over 4-word chunks, scalar tail.
+#define MINLAB_AVX2_BINARY(fn, vexpr, sexpr)                                          \
+    MINLAB_AVX2 static void fn(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n) { \
+        const __m256i ones = _mm256_set1_epi64x(-1);                                  \
+        (void)ones;                                                                   \
+        size_t i = 0;                                                                 \
+        for (; i + 4 <= n; i += 4) {                                                  \
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));  \
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));  \
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(o + i), vexpr);            \
+        }                                                                             \
+        for (; i < n; ++i) o[i] = sexpr;                                              \
+    }
+
+MINLAB_AVX2 static void notOp(uint64_t* o, const uint64_t* a, size_t n) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(o + i), _mm256_xor_si256(x, ones));
+    }
+    for (; i < n; ++i) o[i] = ~a[i];
+}
+MINLAB_AVX2_BINARY(andOp, _mm256_and_si256(x, y), a[i] & b[i])
+MINLAB_AVX2_BINARY(orOp, _mm256_or_si256(x, y), a[i] | b[i])
+MINLAB_AVX2_BINARY(xorOp, _mm256_xor_si256(x, y), a[i] ^ b[i])
+MINLAB_AVX2_BINARY(nandOp, _mm256_xor_si256(_mm256_and_si256(x, y), ones), ~(a[i] & b[i]))
+MINLAB_AVX2_BINARY(norOp, _mm256_xor_si256(_mm256_or_si256(x, y), ones), ~(a[i] | b[i]))
+#undef MINLAB_AVX2_BINARY
+
+// Per-64-bit-lane bit counts: nibble lookups with vpshufb, then summed by vpsadbw.
+MINLAB_AVX2 static __m256i laneCounts(__m256i v) {
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low));
+    __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+    return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+
+MINLAB_AVX2 static uint64_t horizontalSum(__m256i v) {
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+MINLAB_AVX2 static uint64_t popcount(const uint64_t* a, size_t n) {
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        total = _mm256_add_epi64(total, laneCounts(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i))));
+    }
+    uint64_t c = horizontalSum(total);
+    for (; i < n; ++i) c += static_cast<uint64_t>(__builtin_popcountll(a[i]));
+    return c;
+}
+
+MINLAB_AVX2 static uint64_t diffCount(uint64_t* acc, const uint64_t* a, const uint64_t* b, const uint64_t* mask,
+                                      size_t n) {
+    __m256i total = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i m = mask ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask + i)) : ones;
+        __m256i d = _mm256_and_si256(_mm256_xor_si256(x, y), m);
+        __m256i* out = reinterpret_cast<__m256i*>(acc + i);
+        _mm256_storeu_si256(out, _mm256_or_si256(_mm256_loadu_si256(out), d));
+        total = _mm256_add_epi64(total, laneCounts(d));
+    }
+    uint64_t c = horizontalSum(total);
+    for (; i < n; ++i) {
+        uint64_t d = (a[i] ^ b[i]) & (mask ? mask[i] : ~0ull);
+        acc[i] |= d;
+        c += static_cast<uint64_t>(__builtin_popcountll(d));
+    }
+    return c;
+}
+}
+
+namespace avx512 {
+#define MINLAB_AVX512 __attribute__((target("avx512f")))
+// Each gate is a single vpternlogq; imm8 is the truth table over (x, y, x).
+#define MINLAB_AVX512_BINARY(fn, imm, sexpr)                                          \
+    MINLAB_AVX512 static void fn(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n) { \
+        size_t i = 0;                                                                 \
+        for (; i + 8 <= n; i += 8) {                                                  \
+            __m512i x = _mm512_loadu_si512(a + i);                                    \
+            __m512i y = _mm512_loadu_si512(b + i);                                    \
+            _mm512_storeu_si512(o + i, _mm512_ternarylogic_epi64(x, y, x, imm));      \
+        }                                                                             \
+        for (; i < n; ++i) o[i] = sexpr;                                              \
+    }
+
+MINLAB_AVX512 static void notOp(uint64_t* o, const uint64_t* a, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        _mm512_storeu_si512(o + i, _mm512_ternarylogic_epi64(x, x, x, 0x0F));
+    }
+    for (; i < n; ++i) o[i] = ~a[i];
+}
+MINLAB_AVX512_BINARY(andOp, 0xC0, a[i] & b[i])
+MINLAB_AVX512_BINARY(orOp, 0xFC, a[i] | b[i])
+MINLAB_AVX512_BINARY(xorOp, 0x3C, a[i] ^ b[i])
+MINLAB_AVX512_BINARY(nandOp, 0x3F, ~(a[i] & b[i]))
+MINLAB_AVX512_BINARY(norOp, 0x03, ~(a[i] | b[i]))
+#undef MINLAB_AVX512_BINARY
+}
+
+static const GateKernels kAvx2 = {
+    "avx2", avx2::notOp, avx2::andOp, avx2::orOp, avx2::xorOp, avx2::nandOp, avx2::norOp,
+    avx2::popcount, avx2::diffCount,
+};
+// AVX-512F has no byte shuffle or lane popcount, so counting uses the AVX2
+// kernels (every AVX-512 CPU has AVX2)
+static const GateKernels kAvx512 = {
+    "avx512", avx512::notOp, avx512::andOp, avx512::orOp, avx512::xorOp, avx512::nandOp, avx512::norOp,
+    avx2::popcount, avx2::diffCount,
+};
+#endif
+
+const GateKernels* gateKernelsByName(const std::string& name) {
+    if (name == "scalar") return &kScalar;
+#ifdef MINLAB_X86_KERNELS
+    __builtin_cpu_init();
+    if (name == "avx2" && __builtin_cpu_supports("avx2")) return &kAvx2;
+    if (name == "avx512" && __builtin_cpu_supports("avx512f")) return &kAvx512;
+#endif
+    return nullptr;
+}
+
+static const GateKernels& detectKernels() {
+    if (const char* forced = std::getenv("MINLAB_KERNELS")) {
+        if (const GateKernels* k = gateKernelsByName(forced)) return *k;
+    }
+    for (const char* name : {"avx512", "avx2"}) {
+        if (const GateKernels* k = gateKernelsByName(name)) return *k;
+    }
+    return kScalar;
+}
+
+const GateKernels& gateKernels() {
+    static const GateKernels& chosen = detectKernels();
+    return chosen;
+}
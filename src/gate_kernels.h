@@ -0,0 +1,34 @@
+#ifndef GATE_KERNELS_H
+#define GATE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Word-array kernels for the bit-parallel engine. Each gate call evaluates
+// one gate over n words (64 input vectors per word); the SIMD variants
+// process 256 or 512 vectors per instruction. The counting kernels tally
+// set bits for checking results against expected tables.
+struct GateKernels {
+    const char* name;
+    void (*notOp)(uint64_t* o, const uint64_t* a, size_t n);
+    void (*andOp)(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n);
+    void (*orOp)(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n);
+    void (*xorOp)(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n);
+    void (*nandOp)(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n);
+    void (*norOp)(uint64_t* o, const uint64_t* a, const uint64_t* b, size_t n);
+    // Set bits in a[0, n).
+    uint64_t (*popcount)(const uint64_t* a, size_t n);
+    // Set bits in (a ^ b) & mask, each word of which is also ORed into acc;
+    // a null mask selects every bit.
+    uint64_t (*diffCount)(uint64_t* acc, const uint64_t* a, const uint64_t* b, const uint64_t* mask, size_t n);
+};
+
+// Best kernel set for this CPU, picked once from CPUID. The environment
+// variable MINLAB_KERNELS=scalar|avx2|avx512 can force a narrower choice.
+const GateKernels& gateKernels();
+
+// Kernel set by name, or nullptr if unknown or unsupported on this CPU.
+const GateKernels* gateKernelsByName(const std::string& name);
+
+#endif
@@ -1,15 +1,30 @@
 #include "simulator.h"
+#include "bitsim.h"
+#include "net_optimizer.h"
+#include "aig.h"
+#include "bdd.h"
+#include "native.h"
+#include "truth_file.h"
+#include "table_format.h"
+#include "equivalence.h"
 #include "game.h"
 #include "terminal_ui.h"
 #include "level_editor.h"
 #include "component_designer.h"
+#include <cmath>
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
+#include <sstream>
+#include <iomanip>
 #include <vector>
 #include <filesystem>
 #include <limits>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
@@ -19,28 +34,181 @@ static std::string readFile(const std::string& path) {
     return std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
 }
 
-static void printTruthTable(const AST& ast, Net& net) {
-    auto combos = allCombos(ast.inputs);
-    for (auto& in : combos) {
-        auto out = simulate(net, in);
-        std::cout << "in {";
-        bool first = true;
-        for (auto& k : ast.inputs) {
-            if (!first) std::cout << ",";
-            first = false;
-            std::cout << k << ":" << in[k];
-        }
-        std::cout << "} -> out {";
-        first = true;
-        for (auto& k : ast.outputs) {
-            if (!first) std::cout << ",";
-            first = false;
-            std::cout << k << ":" << out[k];
-        }
-        std::cout << "}\n";
+// Rows are formatted on the enumeration workers and written straight to fd
+// in row order, one write() per block.
+static void printTruthTable(const AST& ast, Net& net, unsigned threads, SimEngine engine, TableFormat format,
+                            int fd) {
+    RowFormatter formatter(format, ast.inputs, ast.outputs);
+    writeAll(fd, formatter.header().data(), formatter.header().size());
+    enumerateTruthTableParallel(net, threads,
+        [&](const TruthBlock& block, std::string& text) { formatter.format(block, text); },
+        [&](const std::string& text) { writeAll(fd, text.data(), text.size()); }, 64, engine);
+    writeAll(fd, formatter.footer().data(), formatter.footer().size());
+}
+
+// Larger blocks than the text path so each column slice is one sizeable
+// pwrite; packing runs on the workers.
+static void writeTruthFile(const AST& ast, Net& net, unsigned threads, SimEngine engine, int fd) {
+    TruthFileWriter writer(fd, ast.inputs, ast.outputs);
+    enumerateTruthTableParallel(net, threads, TruthFileWriter::pack,
+        [&](const std::string& buf) { writer.append(buf); }, 1024, engine);
+    writer.finish();
+}
+
+// An input assignment, formatted like the text table.
+static std::string formatInputs(const std::vector<std::string>& inputs, const std::vector<int>& values) {
+    std::string s = "{";
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (i) s += ",";
+        s += inputs[i] + ":" + std::to_string(values[i]);
+    }
+    return s + "}";
+}
+
+// Input assignment of a row.
+static std::string formatInputs(const std::vector<std::string>& inputs, uint64_t row) {
+    std::vector<int> values;
+    for (size_t i = 0; i < inputs.size(); ++i) values.push_back(static_cast<int>((row >> i) & 1));
+    return formatInputs(inputs, values);
+}
+
+// minlab tt-diff a.bin b.bin
+static int ttDiffCommand(int argc, char** argv) {
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " tt-diff a.bin b.bin\n";
+        return 2;
+    }
+    try {
+        TruthFile a(argv[2]), b(argv[3]);
+        if (a.inputs() != b.inputs()) {
+            std::cerr << "Error: tables have different inputs\n";
+            return 2;
+        }
+        size_t differing = 0;
+        for (size_t oa = 0; oa < a.outputs().size(); ++oa) {
+            const std::string& name = a.outputs()[oa];
+            auto it = std::find(b.outputs().begin(), b.outputs().end(), name);
+            if (it == b.outputs().end()) {
+                std::cout << name << ": only in " << argv[2] << "\n";
+                ++differing;
+                continue;
+            }
+            uint64_t first = 0;
+            uint64_t n = countDifferences(a.column(oa), b.column(it - b.outputs().begin()), a.columnWords(), first);
+            if (n == 0) continue;
+            std::cout << name << ": " << n << " of " << a.rows() << " rows differ, first at "
+                      << formatInputs(a.inputs(), first) << "\n";
+            ++differing;
+        }
+        for (const auto& name : b.outputs()) {
+            if (std::find(a.outputs().begin(), a.outputs().end(), name) == a.outputs().end()) {
+                std::cout << name << ": only in " << argv[3] << "\n";
+                ++differing;
+            }
+        }
+        if (differing == 0) {
+            std::cout << "Tables match (" << a.rows() << " rows, " << a.outputs().size() << " outputs)\n";
+            return 0;
+        }
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+}
+
+// minlab equiv a.hdl b.hdl
+static int equivCommand(int argc, char** argv) {
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " equiv a.hdl b.hdl\n";
+        return 2;
+    }
+    try {
+        Net nets[2];
+        for (int k = 0; k < 2; ++k) {
+            std::string path = argv[2 + k];
+            std::string s = readFile(path);
+            if (s.empty() && !fs::exists(path)) throw std::runtime_error("Cannot open " + path);
+            nets[k] = buildNet(parseHDL(s));
+            optimizeNet(nets[k]);
+        }
+        EquivalenceResult r = checkEquivalence(nets[0], nets[1]);
+        if (r.equivalent) {
+            std::cout << "Equivalent (" << nets[0].ast.inputs.size() << " inputs, " << nets[0].ast.outputs.size()
+                      << " outputs)\n";
+            return 0;
+        }
+        std::cout << "Not equivalent at " << formatInputs(nets[0].ast.inputs, r.counterexample) << "\n";
+        for (size_t o = 0; o < r.outA.size(); ++o) {
+            if (r.outA[o] == r.outB[o]) continue;
+            std::cout << "  " << nets[0].ast.outputs[o] << ": " << r.outA[o] << " in " << argv[2] << ", " << r.outB[o]
+                      << " in " << argv[3] << "\n";
+        }
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
     }
 }
 
+// minlab count file.hdl
+static int countCommand(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " count file.hdl\n";
+        return 2;
+    }
+    try {
+        std::string path = argv[2];
+        std::string s = readFile(path);
+        if (s.empty() && !fs::exists(path)) throw std::runtime_error("Cannot open " + path);
+        Net net = buildNet(parseHDL(s));
+        optimizeNet(net);
+        // Counted on each output's BDD, so no row is ever enumerated
+        BddManager mgr;
+        std::vector<Bdd> f = buildBdds(mgr, net);
+        std::cout << std::fixed << std::setprecision(0);
+        for (size_t o = 0; o < f.size(); ++o) {
+            std::cout << net.ast.outputs[o] << ": " << mgr.satCount(f[o]) << " of "
+                      << std::ldexp(1.0, static_cast<int>(net.inputIds.size())) << " rows true (BDD nodes: "
+                      << mgr.nodeCount({f[o]}) << ")\n";
+        }
+        std::cout << "BDD nodes for all outputs: " << mgr.nodeCount(f) << "\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+}
+
+// minlab compile file.hdl [-o file.so]
+static int compileCommand(int argc, char** argv) {
+    std::string path, out;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) out = argv[++i];
+        else path = arg;
+    }
+    if (path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " compile file.hdl [-o file.so]\n";
+        return 2;
+    }
+    if (out.empty()) out = fs::path(path).replace_extension(".so").string();
+    std::string s = readFile(path);
+    if (s.empty() && !fs::exists(path)) {
+        std::cerr << "Cannot open " << path << "\n";
+        return 2;
+    }
+    try {
+        Net net = buildNet(parseHDL(s));
+        optimizeNet(net);
+        fs::copy_file(compileNative(net), out, fs::copy_options::overwrite_existing);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+    return 0;
+}
+
 static void playLevel(Game& game, const Level& level) {
     LevelEditor editor(game, level);
     editor.run();
@@ -141,23 +309,123 @@ int main(int argc, char** argv) {
         return 0;
     }
     
+    if (std::string(argv[1]) == "compile") return compileCommand(argc, argv);
+    if (std::string(argv[1]) == "tt-diff") return ttDiffCommand(argc, argv);
+    if (std::string(argv[1]) == "equiv") return equivCommand(argc, argv);
+    if (std::string(argv[1]) == "count") return countCommand(argc, argv);
+    
     // If argument is provided, use legacy mode (backward compatibility)
-    if (argc >= 2) {
-        std::ifstream f(argv[1]);
-        if (!f) {
-            std::cerr << "Cannot open " << argv[1] << "\n";
+    // minlab [--threads N] [--engine netlist|aig|native] [--format text|csv|pla|bin] [-o file] [--outputs a,b] [--stats] file.hdl
+    std::string path, outPath;
+    std::vector<std::string> onlyOutputs;
+    TableFormat format = TableFormat::Text;
+    unsigned threads = 1;
+    SimEngine engine = SimEngine::Netlist;
+    bool stats = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value;
+        if (arg == "--stats") {
+            stats = true;
+            continue;
+        } else if (arg == "--engine" || arg.rfind("--engine=", 0) == 0) {
+            std::string name = arg == "--engine" ? (i + 1 < argc ? argv[++i] : "") : arg.substr(9);
+            if (!simEngineByName(name, engine)) {
+                std::cerr << "Unknown engine: " << name << " (expected netlist, aig or native)\n";
+                return 1;
+            }
+            continue;
+        } else if (arg == "--format" || arg.rfind("--format=", 0) == 0) {
+            std::string name = arg == "--format" ? (i + 1 < argc ? argv[++i] : "") : arg.substr(9);
+            if (!tableFormatByName(name, format)) {
+                std::cerr << "Unknown format: " << name << " (expected text, csv, pla or bin)\n";
+                return 1;
+            }
+            continue;
+        } else if (arg == "-o" && i + 1 < argc) {
+            outPath = argv[++i];
+            continue;
+        } else if (arg == "--outputs" || arg.rfind("--outputs=", 0) == 0) {
+            std::string list = arg == "--outputs" ? (i + 1 < argc ? argv[++i] : "") : arg.substr(10);
+            std::stringstream ss(list);
+            for (std::string name; std::getline(ss, name, ',');) {
+                if (!name.empty()) onlyOutputs.push_back(name);
+            }
+            if (onlyOutputs.empty()) {
+                std::cerr << "--outputs needs a comma-separated list of outputs\n";
+                return 1;
+            }
+            continue;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            value = argv[++i];
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            value = arg.substr(10);
+        } else {
+            path = arg;
+            continue;
+        }
+        try {
+            threads = static_cast<unsigned>(std::stoul(value));
+        } catch (const std::exception&) {
+            std::cerr << "Invalid thread count: " << value << "\n";
+            return 1;
+        }
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (path.empty()) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--threads N] [--engine netlist|aig|native] [--format text|csv|pla|bin] [-o file]\n"
+                  << "       [--outputs a,b] [--stats] file.hdl\n"
+                  << "       " << argv[0] << " compile file.hdl [-o file.so]\n"
+                  << "       " << argv[0] << " tt-diff a.bin b.bin\n"
+                  << "       " << argv[0] << " equiv a.hdl b.hdl\n"
+                  << "       " << argv[0] << " count file.hdl\n";
         return 1;
     }
-        std::string s((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
-        try {
+    
+    std::ifstream f(path);
+    if (!f) {
+        std::cerr << "Cannot open " << path << "\n";
+        return 1;
+    }
+    std::string s((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    try {
         AST ast = parseHDL(s);
         Net net = buildNet(ast);
-            printTruthTable(ast, net);
-        } catch (const std::exception& e) {
-            std::cerr << "Error: " << e.what() << "\n";
-            return 2;
+        if (!onlyOutputs.empty()) {
+            // Only the requested outputs' fan-in cones are kept from here on
+            net = coneNet(net, onlyOutputs);
+            ast.outputs = onlyOutputs;
         }
-        return 0;
+        OptimizeStats opt = optimizeNet(net);
+        if (stats) {
+            std::cerr << "gates: " << opt.gatesBefore << " -> " << opt.gatesAfter
+                      << " (" << opt.folded << " folded, " << opt.merged << " merged, "
+                      << opt.dead << " dead)\n";
+            if (engine == SimEngine::Aig && BitSim::supports(net)) {
+                Aig aig = buildAig(net);
+                std::cerr << "aig: " << aig.numAnds() << " ands, depth " << aig.depth() << "\n";
+            }
+        }
+        int fd = outPath.empty() ? STDOUT_FILENO : open(outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::runtime_error("Cannot write " + outPath);
+        try {
+            if (format == TableFormat::Bin) writeTruthFile(ast, net, threads, engine, fd);
+            else printTruthTable(ast, net, threads, engine, format, fd);
+        } catch (...) {
+            if (fd != STDOUT_FILENO) close(fd);
+            throw;
+        }
+        if (fd != STDOUT_FILENO) close(fd);
+        std::vector<std::string> oscillating = oscillatingParts(net);
+        if (!oscillating.empty()) {
+            std::cerr << "Warning: feedback loop oscillates (parts:";
+            for (const auto& p : oscillating) std::cerr << " " << p;
+            std::cerr << ")\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
     }
     
     return 0;
@@ -0,0 +1,213 @@
+#include "native.h"
+#include <dlfcn.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#ifndef MINLAB_CXX
+#define MINLAB_CXX "c++"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+class NativeEmitter {
+public:
+    std::ostringstream body;  // statements of the per-word loop
+
+    // Emits net's gates over the given input expressions and returns the
+    // expressions of its outputs.
+    std::vector<std::string> emit(const Net& net, const std::vector<std::string>& ins) {
+        if (net.cyclic) throw std::runtime_error("Native code generation does not support feedback loops");
+        std::vector<std::string> name(net.numSignals(), "0ull");
+        name[Net::kConst1] = "~0ull";
+        for (size_t i = 0; i < net.inputIds.size(); ++i) name[net.inputIds[i]] = ins[i];
+        for (const auto& g : net.gates) {
+            const std::string& a = name[g.in1];
+            const std::string& b = name[g.in2];
+            switch (g.op) {
+                case GateOp::Not: name[g.out] = temp("~" + a); break;
+                case GateOp::And: name[g.out] = temp(a + " & " + b); break;
+                case GateOp::Or: name[g.out] = temp(a + " | " + b); break;
+                case GateOp::Xor: name[g.out] = temp(a + " ^ " + b); break;
+                case GateOp::Nand: name[g.out] = temp("~(" + a + " & " + b + ")"); break;
+                case GateOp::Nor: name[g.out] = temp("~(" + a + " | " + b + ")"); break;
+                case GateOp::Sub: {
+                    const Net::SubInstance& inst = net.subs[g.sub];
+                    std::vector<std::string> subIns;
+                    for (uint32_t s : inst.ins) subIns.push_back(name[s]);
+                    std::vector<std::string> subOuts = emit(inst.net[0], subIns);
+                    for (size_t i = 0; i < inst.outs.size(); ++i) name[inst.outs[i]] = subOuts[i];
+                    break;
+                }
+                case GateOp::Lut: {
+                    const Net::LutInstance& lut = net.luts[g.sub];
+                    std::vector<std::string> x;
+                    for (uint32_t s : lut.ins) x.push_back(name[s]);
+                    name[g.out] = x.size() <= 6 ? lutMux(lut.bits()[0], static_cast<unsigned>(x.size()), x)
+                                                : lutTable(lut, x);
+                    break;
+                }
+            }
+        }
+        std::vector<std::string> outs;
+        for (uint32_t s : net.outputIds) outs.push_back(name[s]);
+        return outs;
+    }
+
+private:
+    size_t temps_ = 0;
+
+    std::string temp(const std::string& expr) {
+        std::string t = "t" + std::to_string(temps_++);
+        body << "        const uint64_t " << t << " = " << expr << ";\n";
+        return t;
+    }
+
+    // Shannon expansion, the same as BitSim's lutWord but unrolled at
+    // generation time since the table is a constant.
+    std::string lutMux(uint64_t table, unsigned k, const std::vector<std::string>& x) {
+        uint64_t rows = 1ull << k;
+        uint64_t mask = rows == 64 ? ~0ull : (1ull << rows) - 1;
+        table &= mask;
+        if (table == 0) return "0ull";
+        if (table == mask) return "~0ull";
+        unsigned half = static_cast<unsigned>(rows / 2);
+        std::string lo = lutMux(table & ((1ull << half) - 1), k - 1, x);
+        std::string hi = lutMux(table >> half, k - 1, x);
+        const std::string& s = x[k - 1];
+        return temp("(" + lo + " & ~" + s + ") | (" + hi + " & " + s + ")");
+    }
+
+    // Wide tables: the shared mux steps of lutSteps(), one temp each.
+    std::string lutTable(const Net::LutInstance& lut, const std::vector<std::string>& x) {
+        std::vector<std::string> v{"0ull", "~0ull"};
+        for (const LutStep& s : lutSteps(lut)) {
+            const std::string& sel = x[s.sel];
+            v.push_back(temp("(" + v[s.lo] + " & ~" + sel + ") | (" + v[s.hi] + " & " + sel + ")"));
+        }
+        return v.back();
+    }
+};
+
+std::string shellQuote(const std::string& s) {
+    std::string q = "'";
+    for (char c : s) {
+        if (c == '\'') q += "'\\''";
+        else q += c;
+    }
+    return q + "'";
+}
+
+uint64_t fnv1a(const std::string& s) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+}
+
+std::string generateNativeSource(const Net& net) {
+    NativeEmitter e;
+    std::vector<std::string> ins;
+    for (size_t i = 0; i < net.inputIds.size(); ++i) ins.push_back("i" + std::to_string(i));
+    std::vector<std::string> outs = e.emit(net, ins);
+
+    std::ostringstream src;
+    src << "// Generated by minlab. Do not edit.\n"
+        << "#include <cstddef>\n#include <cstdint>\n\n"
+        << "extern \"C\" const unsigned minlab_ports[2] = {" << net.inputIds.size() << ", "
+        << net.outputIds.size() << "};\n\n"
+        << "extern \"C\" void minlab_eval(const uint64_t* in, uint64_t* out, size_t words) {\n"
+        << "    for (size_t w = 0; w < words; ++w) {\n";
+    for (size_t i = 0; i < ins.size(); ++i) {
+        src << "        const uint64_t " << ins[i] << " = in[" << i << " * words + w];\n";
+    }
+    src << e.body.str();
+    for (size_t o = 0; o < outs.size(); ++o) {
+        src << "        out[" << o << " * words + w] = " << outs[o] << ";\n";
+    }
+    src << "    }\n}\n";
+    return src.str();
+}
+
+std::string nativeCacheDirectory() {
+    if (const char* dir = std::getenv("MINLAB_CACHE")) return dir;
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : ".") + "/.minlab/cache";
+}
+
+std::string compileNative(const Net& net) {
+    const char* cxxEnv = std::getenv("CXX");
+    std::string cxx = cxxEnv && *cxxEnv ? cxxEnv : MINLAB_CXX;
+    const std::string flags = "-O2 -shared -fPIC";
+    std::string source = generateNativeSource(net);
+
+    // The key covers the compiler and flags too, so changing either rebuilds.
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << fnv1a(cxx + "\n" + flags + "\n" + source);
+    fs::path dir = nativeCacheDirectory();
+    fs::path lib = dir / (key.str() + ".so");
+    if (fs::exists(lib)) return lib.string();
+
+    fs::create_directories(dir);
+    std::string tag = key.str() + "." + std::to_string(getpid());
+    fs::path src = dir / (tag + ".cpp"), tmp = dir / (tag + ".so"), log = dir / (tag + ".log");
+    {
+        std::ofstream f(src);
+        if (!f) throw std::runtime_error("Cannot write " + src.string());
+        f << source;
+    }
+    std::string cmd = shellQuote(cxx) + " " + flags + " -o " + shellQuote(tmp.string()) + " " +
+                      shellQuote(src.string()) + " > " + shellQuote(log.string()) + " 2>&1";
+    int status = std::system(cmd.c_str());
+    std::error_code ec;
+    if (status != 0) {
+        std::ifstream f(log);
+        std::string first;
+        std::getline(f, first);
+        fs::remove(src, ec);
+        fs::remove(log, ec);
+        fs::remove(tmp, ec);
+        throw std::runtime_error("Native compile failed (" + cxx + "): " + first);
+    }
+    // Publish atomically so concurrent runs never load a half-written file
+    fs::rename(tmp, lib);
+    fs::remove(src, ec);
+    fs::remove(log, ec);
+    return lib.string();
+}
+
+NativeModule::NativeModule(const std::string& path) {
+    // dlopen only searches the library path for names without a slash
+    std::string full = path.find('/') == std::string::npos ? "./" + path : path;
+    handle_ = dlopen(full.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle_) throw std::runtime_error(std::string("Cannot load ") + path + ": " + dlerror());
+    auto ports = static_cast<const unsigned*>(dlsym(handle_, "minlab_ports"));
+    eval_ = reinterpret_cast<EvalFn>(dlsym(handle_, "minlab_eval"));
+    if (!ports || !eval_) {
+        dlclose(handle_);
+        throw std::runtime_error("Not a minlab circuit library: " + path);
+    }
+    inputs_ = ports[0];
+    outputs_ = ports[1];
+}
+
+NativeModule::~NativeModule() {
+    dlclose(handle_);
+}
+
+NativeSim::NativeSim(std::shared_ptr<const NativeModule> module, size_t words)
+    : WordSim(module->inputs(), words), module_(std::move(module)),
+      in_(module_->inputs() * words_, 0), out_(module_->outputs() * words_, 0) {}
+
+std::unique_ptr<WordSim> NativeSim::fork() const {
+    return std::make_unique<NativeSim>(module_, words_);
+}
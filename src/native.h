@@ -0,0 +1,68 @@
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include "simulator.h"
+#include "bitsim.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Native back end: an acyclic net is translated into straight-line C++
+// over uint64_t lanes, compiled into a shared object by the system C++
+// compiler and loaded with dlopen. The generated library exports
+//
+//   extern "C" const unsigned minlab_ports[2];   // {inputs, outputs}
+//   extern "C" void minlab_eval(const uint64_t* in, uint64_t* out, size_t words);
+//
+// with input i in in[i*words, (i+1)*words) and outputs laid out alike.
+
+// C++ source for net. Sub-instances are inlined and lookup tables become
+// mux trees (up to 6 inputs) or embedded tables. Throws for cyclic nets.
+std::string generateNativeSource(const Net& net);
+
+// Directory compiled libraries are cached in: $MINLAB_CACHE if set,
+// otherwise ~/.minlab/cache.
+std::string nativeCacheDirectory();
+
+// Compiles net unless a library for the same generated source is already
+// cached, and returns the cached library's path. The compiler is $CXX if
+// set, otherwise the one minlab was built with. Throws if it fails.
+std::string compileNative(const Net& net);
+
+// A loaded library; dlclose()d when the last user goes away.
+class NativeModule {
+public:
+    using EvalFn = void (*)(const uint64_t* in, uint64_t* out, size_t words);
+
+    // Throws if the file cannot be loaded or lacks the minlab exports.
+    explicit NativeModule(const std::string& path);
+    ~NativeModule();
+    NativeModule(const NativeModule&) = delete;
+    NativeModule& operator=(const NativeModule&) = delete;
+
+    size_t inputs() const { return inputs_; }
+    size_t outputs() const { return outputs_; }
+    EvalFn eval() const { return eval_; }
+
+private:
+    void* handle_ = nullptr;
+    EvalFn eval_ = nullptr;
+    size_t inputs_ = 0, outputs_ = 0;
+};
+
+// Word-parallel evaluator that calls into a compiled library.
+class NativeSim : public WordSim {
+public:
+    NativeSim(std::shared_ptr<const NativeModule> module, size_t words = 1);
+
+    uint64_t* input(size_t i) override { return in_.data() + i * words_; }
+    const uint64_t* output(size_t i) const override { return out_.data() + i * words_; }
+    void run() override { module_->eval()(in_.data(), out_.data(), words_); }
+    std::unique_ptr<WordSim> fork() const override;
+
+private:
+    std::shared_ptr<const NativeModule> module_;
+    std::vector<uint64_t> in_, out_;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "net_optimizer.h"
+#include <unordered_map>
+#include <numeric>
+#include <utility>
+
+namespace {
+constexpr uint32_t kNoSignal = Net::kNoSignal;
+
+struct GateKey {
+    GateOp op;
+    uint32_t a, b;
+    bool operator==(const GateKey& o) const { return op == o.op && a == o.a && b == o.b; }
+};
+
+struct GateKeyHash {
+    size_t operator()(const GateKey& k) const {
+        uint64_t h = (static_cast<uint64_t>(k.a) << 32 | k.b) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 29) ^ static_cast<uint64_t>(k.op));
+    }
+};
+
+// Constants are signals 0 and 1, so a constant's id is also its value.
+bool isConst(uint32_t s) { return s <= Net::kConst1; }
+
+// Local rewrite of one gate over already simplified operands. Returns the
+// signal the gate reduces to, or kNoSignal if a gate (possibly with a new
+// op/operands, e.g. XOR(1,x) -> NOT x) is still needed.
+uint32_t fold(GateOp& op, uint32_t& a, uint32_t& b, const std::vector<uint32_t>& notOf) {
+    if (op != GateOp::Not) {
+        if (a > b) std::swap(a, b);  // every binary op is commutative
+        bool complementary = notOf[a] == b || notOf[b] == a;
+        switch (op) {
+            case GateOp::And:
+                if (a == Net::kConst0 || complementary) return Net::kConst0;
+                if (a == Net::kConst1 || a == b) return b;
+                return kNoSignal;
+            case GateOp::Or:
+                if (a == Net::kConst1 || complementary) return Net::kConst1;
+                if (a == Net::kConst0 || a == b) return b;
+                return kNoSignal;
+            case GateOp::Xor:
+                if (a == b) return Net::kConst0;
+                if (complementary) return Net::kConst1;
+                if (a == Net::kConst0) return b;
+                if (a != Net::kConst1) return kNoSignal;
+                a = b;
+                break;
+            case GateOp::Nand:
+                if (a == Net::kConst0 || complementary) return Net::kConst1;
+                if (a == Net::kConst1) a = b;
+                else if (a != b) return kNoSignal;
+                break;
+            case GateOp::Nor:
+                if (a == Net::kConst1) return Net::kConst0;
+                if (complementary) return Net::kConst0;
+                if (a == Net::kConst0) a = b;
+                else if (a != b) return kNoSignal;
+                break;
+            default:
+                return kNoSignal;
+        }
+        op = GateOp::Not;  // fell through to an inverter of a
+    }
+    b = a;
+    if (isConst(a)) return a ^ 1;
+    if (notOf[a] != kNoSignal) return notOf[a];
+    return kNoSignal;
+}
+}
+
+OptimizeStats optimizeNet(Net& net) {
+    OptimizeStats st;
+    st.gatesBefore = net.gates.size();
+    const uint32_t n = net.numSignals();
+    std::vector<uint32_t> repl(n), notOf(n, kNoSignal);
+    std::iota(repl.begin(), repl.end(), 0);
+    std::unordered_map<GateKey, uint32_t, GateKeyHash> seen;
+    std::vector<Net::Gate> kept;
+    kept.reserve(net.gates.size());
+
+    // Gates are in topological order, so operands are final when reached.
+    for (uint32_t gi = 0; gi < net.gates.size(); ++gi) {
+        Net::Gate g = net.gates[gi];
+        if (g.op == GateOp::Sub) {
+            for (auto& s : net.subs[g.sub].ins) s = repl[s];
+            kept.push_back(g);
+            continue;
+        }
+        if (g.op == GateOp::Lut) {
+            for (auto& s : net.luts[g.sub].ins) s = repl[s];
+            kept.push_back(g);
+            continue;
+        }
+        g.in1 = repl[g.in1];
+        g.in2 = g.op == GateOp::Not ? g.in1 : repl[g.in2];
+        if (net.loopOf[gi] != kNoSignal) {
+            // Inside a feedback loop: values depend on history, keep as is
+            kept.push_back(g);
+            continue;
+        }
+        uint32_t alias = fold(g.op, g.in1, g.in2, notOf);
+        if (alias != kNoSignal) {
+            repl[g.out] = alias;
+            st.folded++;
+            continue;
+        }
+        auto [it, inserted] = seen.emplace(GateKey{g.op, g.in1, g.in2}, g.out);
+        if (!inserted) {
+            repl[g.out] = it->second;
+            st.merged++;
+            continue;
+        }
+        if (g.op == GateOp::Not) notOf[g.out] = g.in1;
+        kept.push_back(g);
+    }
+    for (auto& s : net.outputIds) s = repl[s];
+
+    // Keep only gates in the fan-in cone of some output
+    std::vector<uint32_t> driver(n, kNoSignal);
+    for (uint32_t gi = 0; gi < kept.size(); ++gi) {
+        net.forEachOutput(kept[gi], [&](uint32_t s) { driver[s] = gi; });
+    }
+    std::vector<uint8_t> live(kept.size(), 0);
+    std::vector<uint32_t> work(net.outputIds.begin(), net.outputIds.end());
+    while (!work.empty()) {
+        uint32_t s = work.back();
+        work.pop_back();
+        uint32_t gi = driver[s];
+        if (gi == kNoSignal || live[gi]) continue;
+        live[gi] = 1;
+        net.forEachInput(kept[gi], [&](uint32_t in) { work.push_back(in); });
+    }
+
+    std::vector<Net::Gate> gates;
+    std::vector<Net::SubInstance> subs;
+    std::vector<Net::LutInstance> luts;
+    for (uint32_t gi = 0; gi < kept.size(); ++gi) {
+        if (!live[gi]) {
+            st.dead++;
+            continue;
+        }
+        Net::Gate g = kept[gi];
+        if (g.op == GateOp::Sub) {
+            subs.push_back(std::move(net.subs[g.sub]));
+            g.sub = static_cast<uint32_t>(subs.size() - 1);
+        } else if (g.op == GateOp::Lut) {
+            luts.push_back(std::move(net.luts[g.sub]));
+            g.sub = static_cast<uint32_t>(luts.size() - 1);
+        }
+        gates.push_back(g);
+    }
+    net.gates = std::move(gates);
+    net.subs = std::move(subs);
+    net.luts = std::move(luts);
+    levelizeNet(net);
+
+    st.gatesAfter = net.gates.size();
+    return st;
+}
@@ -0,0 +1,25 @@
+#ifndef NET_OPTIMIZER_H
+#define NET_OPTIMIZER_H
+
+#include "simulator.h"
+#include <cstddef>
+
+struct OptimizeStats {
+    size_t gatesBefore = 0;
+    size_t gatesAfter = 0;
+    size_t folded = 0;   // replaced by a constant or an existing signal
+    size_t merged = 0;   // structurally identical to an earlier gate
+    size_t dead = 0;     // outside every output's fan-in cone
+
+    size_t removed() const { return gatesBefore - gatesAfter; }
+};
+
+// Simplifies a built net without changing its input/output behaviour:
+// constant propagation and local rewrites (x&x, x^1, NAND(x,x) -> NOT x,
+// NOT NOT x -> x), structural hashing of identical gates, and removal of
+// gates that no output depends on. Gates inside feedback loops are only
+// re-pointed at simplified signals and removed if dead, so latch
+// behaviour is preserved.
+OptimizeStats optimizeNet(Net& net);
+
+#endif
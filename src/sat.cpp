@@ -0,0 +1,336 @@
+#include "sat.h"
+#include <algorithm>
+
+namespace {
+constexpr double kVarDecay = 0.95;
+constexpr uint64_t kRestartBase = 100;  // conflicts per Luby unit
+constexpr size_t kMinLearnts = 2000;
+
+// Luby sequence 1, 1, 2, 1, 1, 2, 4, ... (i from 0)
+uint64_t luby(uint64_t i) {
+    uint64_t size = 1, seq = 0;
+    while (size < i + 1) {
+        ++seq;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != i) {
+        size = (size - 1) >> 1;
+        --seq;
+        i %= size;
+    }
+    return 1ull << seq;
+}
+}
+
+uint32_t SatSolver::newVar() {
+    uint32_t v = numVars();
+    assign_.push_back(kUndef);
+    phase_.push_back(kFalse);
+    seen_.push_back(0);
+    level_.push_back(0);
+    reason_.push_back(kNoClause);
+    activity_.push_back(0.0);
+    heapIndex_.push_back(UINT32_MAX);
+    watches_.emplace_back();
+    watches_.emplace_back();
+    heapInsert(v);
+    return v;
+}
+
+bool SatSolver::addClause(std::vector<uint32_t> lits) {
+    if (!ok_) return false;
+    cancelUntil(0);
+    // Drop false and repeated literals; satisfied or tautological clauses are no-ops
+    std::sort(lits.begin(), lits.end());
+    size_t j = 0;
+    for (size_t i = 0; i < lits.size(); ++i) {
+        uint8_t v = valueOf(lits[i]);
+        if (v == kTrue || (j > 0 && lits[i] == (lits[j - 1] ^ 1))) return true;
+        if (v == kFalse || (j > 0 && lits[i] == lits[j - 1])) continue;
+        lits[j++] = lits[i];
+    }
+    lits.resize(j);
+    if (lits.empty()) return ok_ = false;
+    if (lits.size() == 1) {
+        enqueue(lits[0], kNoClause);
+        return ok_ = propagate() == kNoClause;
+    }
+    clauses_.push_back({std::move(lits), false, false, 0});
+    attach(static_cast<uint32_t>(clauses_.size() - 1));
+    return true;
+}
+
+void SatSolver::attach(uint32_t c) {
+    const std::vector<uint32_t>& lits = clauses_[c].lits;
+    watches_[lits[0]].push_back({c, lits[1]});
+    watches_[lits[1]].push_back({c, lits[0]});
+}
+
+void SatSolver::enqueue(uint32_t l, uint32_t reason) {
+    uint32_t v = l >> 1;
+    assign_[v] = static_cast<uint8_t>((l & 1) ^ 1);
+    level_[v] = decisionLevel();
+    reason_[v] = reason;
+    trail_.push_back(l);
+}
+
+// Returns the conflicting clause, or kNoClause.
+uint32_t SatSolver::propagate() {
+    uint32_t confl = kNoClause;
+    while (qhead_ < trail_.size()) {
+        uint32_t falseLit = trail_[qhead_++] ^ 1;
+        std::vector<Watcher>& ws = watches_[falseLit];
+        size_t i = 0, j = 0;
+        while (i < ws.size()) {
+            Watcher w = ws[i++];
+            if (valueOf(w.blocker) == kTrue) {
+                ws[j++] = w;
+                continue;
+            }
+            Clause& c = clauses_[w.clause];
+            if (c.deleted) continue;
+            std::vector<uint32_t>& lits = c.lits;
+            if (lits[0] == falseLit) std::swap(lits[0], lits[1]);
+            uint32_t first = lits[0];
+            if (first != w.blocker && valueOf(first) == kTrue) {
+                ws[j++] = {w.clause, first};
+                continue;
+            }
+            bool moved = false;
+            for (size_t k = 2; k < lits.size(); ++k) {
+                if (valueOf(lits[k]) == kFalse) continue;
+                std::swap(lits[1], lits[k]);
+                watches_[lits[1]].push_back({w.clause, first});
+                moved = true;
+                break;
+            }
+            if (moved) continue;
+            ws[j++] = {w.clause, first};
+            if (valueOf(first) == kFalse) {
+                confl = w.clause;
+                qhead_ = trail_.size();
+                while (i < ws.size()) ws[j++] = ws[i++];
+            } else {
+                enqueue(first, w.clause);
+            }
+        }
+        ws.resize(j);
+        if (confl != kNoClause) break;
+    }
+    return confl;
+}
+
+// First-UIP conflict analysis. learnt[0] is the asserting literal and
+// learnt[1] one from backLevel, the level to jump back to.
+void SatSolver::analyze(uint32_t confl, std::vector<uint32_t>& learnt, uint32_t& backLevel, uint32_t& lbd) {
+    learnt.assign(1, 0);
+    int pending = 0;
+    uint32_t p = UINT32_MAX;
+    size_t index = trail_.size();
+    do {
+        const std::vector<uint32_t>& lits = clauses_[confl].lits;
+        for (size_t k = p == UINT32_MAX ? 0 : 1; k < lits.size(); ++k) {
+            uint32_t v = lits[k] >> 1;
+            if (seen_[v] || level_[v] == 0) continue;
+            seen_[v] = 1;
+            bump(v);
+            if (level_[v] >= decisionLevel()) ++pending;
+            else learnt.push_back(lits[k]);
+        }
+        while (!seen_[trail_[--index] >> 1]) {}
+        p = trail_[index];
+        confl = reason_[p >> 1];
+        seen_[p >> 1] = 0;
+    } while (--pending > 0);
+    learnt[0] = p ^ 1;
+
+    // Drop literals implied by the rest of the clause
+    std::vector<uint32_t> marked(learnt.begin() + 1, learnt.end());
+    size_t j = 1;
+    for (size_t i = 1; i < learnt.size(); ++i) {
+        if (!redundant(learnt[i])) learnt[j++] = learnt[i];
+    }
+    learnt.resize(j);
+    for (uint32_t l : marked) seen_[l >> 1] = 0;
+
+    backLevel = 0;
+    size_t at = 1;
+    for (size_t i = 1; i < learnt.size(); ++i) {
+        if (level_[learnt[i] >> 1] > backLevel) {
+            backLevel = level_[learnt[i] >> 1];
+            at = i;
+        }
+    }
+    if (learnt.size() > 1) std::swap(learnt[1], learnt[at]);
+
+    std::vector<uint32_t> levels;
+    for (uint32_t l : learnt) levels.push_back(level_[l >> 1]);
+    std::sort(levels.begin(), levels.end());
+    lbd = static_cast<uint32_t>(std::unique(levels.begin(), levels.end()) - levels.begin());
+}
+
+// A learnt literal is redundant when every other literal of its reason is
+// in the clause already or fixed at level 0.
+bool SatSolver::redundant(uint32_t l) const {
+    uint32_t r = reason_[l >> 1];
+    if (r == kNoClause) return false;
+    const std::vector<uint32_t>& lits = clauses_[r].lits;
+    for (size_t k = 1; k < lits.size(); ++k) {
+        uint32_t v = lits[k] >> 1;
+        if (!seen_[v] && level_[v] > 0) return false;
+    }
+    return true;
+}
+
+void SatSolver::cancelUntil(uint32_t level) {
+    if (decisionLevel() <= level) return;
+    for (size_t i = trail_.size(); i-- > trailLim_[level];) {
+        uint32_t v = trail_[i] >> 1;
+        phase_[v] = assign_[v];
+        assign_[v] = kUndef;
+        reason_[v] = kNoClause;
+        if (heapIndex_[v] == UINT32_MAX) heapInsert(v);
+    }
+    trail_.resize(trailLim_[level]);
+    trailLim_.resize(level);
+    qhead_ = trail_.size();
+}
+
+bool SatSolver::locked(uint32_t c) const {
+    uint32_t v = clauses_[c].lits[0] >> 1;
+    return reason_[v] == c && valueOf(clauses_[c].lits[0]) == kTrue;
+}
+
+// Deletes the worse half of the learnt clauses by LBD, keeping glue
+// clauses (LBD 2) and current reasons. Their watches go lazily.
+void SatSolver::reduceLearnts() {
+    std::vector<uint32_t> candidates;
+    for (uint32_t c = 0; c < clauses_.size(); ++c) {
+        const Clause& cl = clauses_[c];
+        if (cl.learnt && !cl.deleted && cl.lbd > 2 && !locked(c)) candidates.push_back(c);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [&](uint32_t a, uint32_t b) { return clauses_[a].lbd > clauses_[b].lbd; });
+    for (size_t i = 0; i < candidates.size() / 2; ++i) {
+        Clause& cl = clauses_[candidates[i]];
+        cl.deleted = true;
+        std::vector<uint32_t>().swap(cl.lits);
+        --learnts_;
+    }
+    maxLearnts_ += maxLearnts_ / 10;
+}
+
+SatSolver::Result SatSolver::solve(uint64_t conflictLimit) {
+    if (!ok_) return Result::Unsat;
+    cancelUntil(0);
+    if (propagate() != kNoClause) {
+        ok_ = false;
+        return Result::Unsat;
+    }
+    maxLearnts_ = std::max(kMinLearnts, clauses_.size() / 3);
+    const uint64_t start = conflicts_;
+    uint64_t restarts = 0, nextRestart = conflicts_ + kRestartBase * luby(0);
+    std::vector<uint32_t> learnt;
+    for (;;) {
+        uint32_t confl = propagate();
+        if (confl != kNoClause) {
+            ++conflicts_;
+            if (decisionLevel() == 0) {
+                ok_ = false;
+                return Result::Unsat;
+            }
+            uint32_t backLevel, lbd;
+            analyze(confl, learnt, backLevel, lbd);
+            cancelUntil(backLevel);
+            if (learnt.size() == 1) {
+                enqueue(learnt[0], kNoClause);
+            } else {
+                clauses_.push_back({learnt, true, false, lbd});
+                uint32_t c = static_cast<uint32_t>(clauses_.size() - 1);
+                attach(c);
+                enqueue(learnt[0], c);
+                ++learnts_;
+            }
+            varInc_ /= kVarDecay;
+            if (conflictLimit && conflicts_ - start >= conflictLimit) {
+                cancelUntil(0);
+                return Result::Unknown;
+            }
+            continue;
+        }
+        if (conflicts_ >= nextRestart) {
+            nextRestart = conflicts_ + kRestartBase * luby(++restarts);
+            cancelUntil(0);
+        }
+        if (learnts_ >= maxLearnts_) reduceLearnts();
+
+        uint32_t next = UINT32_MAX;
+        while (!heap_.empty()) {
+            uint32_t v = heapPop();
+            if (assign_[v] == kUndef) {
+                next = v;
+                break;
+            }
+        }
+        if (next == UINT32_MAX) {
+            model_ = assign_;
+            cancelUntil(0);
+            return Result::Sat;
+        }
+        trailLim_.push_back(static_cast<uint32_t>(trail_.size()));
+        enqueue(lit(next, phase_[next] != kTrue), kNoClause);
+    }
+}
+
+void SatSolver::bump(uint32_t var) {
+    if ((activity_[var] += varInc_) > 1e100) {
+        for (double& a : activity_) a *= 1e-100;
+        varInc_ *= 1e-100;
+    }
+    if (heapIndex_[var] != UINT32_MAX) heapUp(heapIndex_[var]);
+}
+
+void SatSolver::heapUp(size_t i) {
+    uint32_t v = heap_[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (activity_[heap_[parent]] >= activity_[v]) break;
+        heap_[i] = heap_[parent];
+        heapIndex_[heap_[i]] = static_cast<uint32_t>(i);
+        i = parent;
+    }
+    heap_[i] = v;
+    heapIndex_[v] = static_cast<uint32_t>(i);
+}
+
+void SatSolver::heapDown(size_t i) {
+    uint32_t v = heap_[i];
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= heap_.size()) break;
+        if (child + 1 < heap_.size() && activity_[heap_[child + 1]] > activity_[heap_[child]]) ++child;
+        if (activity_[heap_[child]] <= activity_[v]) break;
+        heap_[i] = heap_[child];
+        heapIndex_[heap_[i]] = static_cast<uint32_t>(i);
+        i = child;
+    }
+    heap_[i] = v;
+    heapIndex_[v] = static_cast<uint32_t>(i);
+}
+
+void SatSolver::heapInsert(uint32_t var) {
+    heap_.push_back(var);
+    heapUp(heap_.size() - 1);
+}
+
+uint32_t SatSolver::heapPop() {
+    uint32_t top = heap_[0];
+    heapIndex_[top] = UINT32_MAX;
+    heap_[0] = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) {
+        heapIndex_[heap_[0]] = 0;
+        heapDown(0);
+    }
+    return top;
+}
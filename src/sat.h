@@ -0,0 +1,84 @@
+#ifndef SAT_H
+#define SAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Conflict-driven clause-learning SAT solver: two watched literals per
+// clause, first-UIP learning with clause minimization, VSIDS branching
+// with phase saving, Luby restarts and LBD-based deletion of learnt
+// clauses. Literals are 2*var + negated, the same encoding Aig uses, so an
+// AIG node can be its own variable.
+class SatSolver {
+public:
+    enum class Result { Sat, Unsat, Unknown };
+
+    static uint32_t lit(uint32_t var, bool negated = false) { return 2 * var + (negated ? 1 : 0); }
+
+    uint32_t newVar();
+    uint32_t numVars() const { return static_cast<uint32_t>(assign_.size()); }
+    // Adds a clause over existing variables. Returns false once the
+    // clauses are unsatisfiable without any search.
+    bool addClause(std::vector<uint32_t> lits);
+
+    // Searches for a model. With a conflict limit (0 = none) gives up with
+    // Unknown after that many conflicts.
+    Result solve(uint64_t conflictLimit = 0);
+    // The last model's value of var (after solve() returned Sat).
+    bool value(uint32_t var) const { return model_[var] == kTrue; }
+    uint64_t conflicts() const { return conflicts_; }
+
+private:
+    static constexpr uint8_t kFalse = 0, kTrue = 1, kUndef = 2;
+    static constexpr uint32_t kNoClause = UINT32_MAX;
+
+    struct Clause {
+        std::vector<uint32_t> lits;  // lits[0..1] are watched; lits[0] is implied when it is a reason
+        bool learnt = false;
+        bool deleted = false;
+        uint32_t lbd = 0;  // distinct decision levels when learnt
+    };
+    struct Watcher {
+        uint32_t clause;
+        uint32_t blocker;  // some other literal of the clause; true means nothing to do
+    };
+
+    bool ok_ = true;
+    std::vector<Clause> clauses_;
+    std::vector<std::vector<Watcher>> watches_;  // per literal: clauses to visit when it becomes false
+    std::vector<uint8_t> assign_, phase_, seen_, model_;
+    std::vector<uint32_t> level_, reason_;
+    std::vector<uint32_t> trail_, trailLim_;
+    size_t qhead_ = 0;
+    uint64_t conflicts_ = 0;
+    size_t learnts_ = 0, maxLearnts_ = 0;
+
+    // VSIDS: a binary max-heap of variables by activity
+    std::vector<double> activity_;
+    double varInc_ = 1.0;
+    std::vector<uint32_t> heap_, heapIndex_;
+
+    uint8_t valueOf(uint32_t l) const {
+        uint8_t v = assign_[l >> 1];
+        return v == kUndef ? kUndef : static_cast<uint8_t>(v ^ (l & 1));
+    }
+    uint32_t decisionLevel() const { return static_cast<uint32_t>(trailLim_.size()); }
+
+    void enqueue(uint32_t l, uint32_t reason);
+    void attach(uint32_t c);
+    uint32_t propagate();
+    void analyze(uint32_t confl, std::vector<uint32_t>& learnt, uint32_t& backLevel, uint32_t& lbd);
+    bool redundant(uint32_t l) const;
+    void cancelUntil(uint32_t level);
+    void reduceLearnts();
+    bool locked(uint32_t c) const;
+
+    void bump(uint32_t var);
+    void heapUp(size_t i);
+    void heapDown(size_t i);
+    void heapInsert(uint32_t var);
+    uint32_t heapPop();
+};
+
+#endif
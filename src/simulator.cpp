@@ -1,5 +1,6 @@
 #include "simulator.h"
 #include "component_library.h"
+#include "bytecode.h"
 #include <sstream>
 #include <regex>
 #include <stdexcept>
@@ -77,15 +78,16 @@ AST parseHDL(const std::string& src) {
     return ast;
 }
 
+
 static GateDef gateOf(const std::string& kind) {
     std::string k;
     for (char c : kind) k += std::tolower(c);
-    if (k == "not") return {{"in"}, {"out"}, [](auto const& p) { return std::unordered_map<std::string, int>{{"out", p.at("in") ^ 1}}; }};
-    if (k == "and") return {{"in1", "in2"}, {"out"}, [](auto const& p) { return std::unordered_map<std::string, int>{{"out", (p.at("in1") & p.at("in2"))}}; }};
-    if (k == "or") return {{"in1", "in2"}, {"out"}, [](auto const& p) { return std::unordered_map<std::string, int>{{"out", (p.at("in1") | p.at("in2"))}}; }};
-    if (k == "xor") return {{"in1", "in2"}, {"out"}, [](auto const& p) { return std::unordered_map<std::string, int>{{"out", (p.at("in1") ^ p.at("in2"))}}; }};
-    if (k == "nand") return {{"in1", "in2"}, {"out"}, [](auto const& p) { return std::unordered_map<std::string, int>{{"out", ((p.at("in1") & p.at("in2")) ^ 1)}}; }};
-    if (k == "nor") return {{"in1", "in2"}, {"out"}, [](auto const& p) { return std::unordered_map<std::string, int>{{"out", ((p.at("in1") | p.at("in2")) ^ 1)}}; }};
+    if (k == "not") return {{"in"}, {"out"}, GateOp::Not};
+    if (k == "and") return {{"in1", "in2"}, {"out"}, GateOp::And};
+    if (k == "or") return {{"in1", "in2"}, {"out"}, GateOp::Or};
+    if (k == "xor") return {{"in1", "in2"}, {"out"}, GateOp::Xor};
+    if (k == "nand") return {{"in1", "in2"}, {"out"}, GateOp::Nand};
+    if (k == "nor") return {{"in1", "in2"}, {"out"}, GateOp::Nor};
     throw std::runtime_error("Unknown gate kind: " + kind);
 }
 
@@ -93,7 +95,7 @@ static std::string pinKey(const std::string& part, const std::string& pin) {
     return "part:" + part + "." + pin;
 }
 
-static std::string resolveSrc(const AST& ast, const std::unordered_map<std::string, int>& have, const std::string& ep) {
+static std::string resolveSrc(const AST& ast, const std::unordered_map<std::string, uint32_t>& have, const std::string& ep) {
     if (ep.find('.') != std::string::npos) {
         std::string part = ep.substr(0, ep.find('.'));
         std::string pin = ep.substr(ep.find('.') + 1);
@@ -106,7 +108,7 @@ static std::string resolveSrc(const AST& ast, const std::unordered_map<std::stri
     throw std::runtime_error("Ambiguous/unknown src: " + ep);
 }
 
-static std::string resolveDst(const AST& ast, const std::unordered_map<std::string, int>& have, const std::string& ep) {
+static std::string resolveDst(const AST& ast, const std::unordered_map<std::string, uint32_t>& have, const std::string& ep) {
     if (ep.find('.') != std::string::npos) {
         std::string part = ep.substr(0, ep.find('.'));
         std::string pin = ep.substr(ep.find('.') + 1);
@@ -124,42 +126,245 @@ static GateDef componentToGateDef(const Component* component) {
     if (!component) {
         throw std::runtime_error("Null component");
     }
-    
-    GateDef g;
-    g.inPins = component->inputs;
-    g.outPins = component->outputs;
-    
-    // Create evaluation function that simulates the component
-    g.eval = [component](const std::unordered_map<std::string, int>& inputs) {
-        // Create input map for component simulation
-        std::unordered_map<std::string, int> componentInputs;
-        for (const auto& in : component->inputs) {
-            if (inputs.find(in) != inputs.end()) {
-                componentInputs[in] = inputs.at(in);
-            } else {
-                componentInputs[in] = 0;  // Default to 0 if not provided
-            }
+    return {component->inputs, component->outputs, GateOp::Sub};
+}
+
+// Build-time table of every named endpoint ("inp:x", "out:x", "part:p.pin").
+// Only used while compiling; simulation never touches strings.
+namespace {
+constexpr uint32_t kNoSignal = Net::kNoSignal;
+
+struct PinTable {
+    std::unordered_map<std::string, uint32_t> slot;
+    std::vector<uint32_t> sig;     // signal driven by this pin, or kNoSignal
+    std::vector<uint32_t> driver;  // slot of the last wire feeding this pin, or kNoSignal
+
+    uint32_t add(const std::string& key, uint32_t s) {
+        auto it = slot.find(key);
+        if (it != slot.end()) {
+            if (s != kNoSignal) sig[it->second] = s;
+            return it->second;
         }
-        
-        // Simulate the component
-        Net componentNet = component->net;  // Copy the net
-        auto outputs = simulate(componentNet, componentInputs);
-        
-        return outputs;
+        uint32_t id = static_cast<uint32_t>(sig.size());
+        slot.emplace(key, id);
+        sig.push_back(s);
+        driver.push_back(kNoSignal);
+        return id;
+    }
+
+    // Follow wire chains (e.g. through gate input pins) to the driving signal.
+    // Undriven pins read as constant 0, as they did before compilation.
+    uint32_t signalOf(uint32_t s) const {
+        for (size_t hops = 0; hops <= sig.size(); ++hops) {
+            if (sig[s] != kNoSignal) return sig[s];
+            if (driver[s] == kNoSignal) break;
+            s = driver[s];
+        }
+        return Net::kConst0;
+    }
+};
+}
+
+static uint32_t newSignal(Net& net, const std::string& name) {
+    net.sigName.push_back(name);
+    net.val.push_back(0);
+    return static_cast<uint32_t>(net.val.size() - 1);
+}
+
+static void buildFanout(Net& net) {
+    uint32_t n = net.numSignals();
+    net.fanStart.assign(n + 1, 0);
+    for (auto& g : net.gates) net.forEachInput(g, [&](uint32_t s) { net.fanStart[s + 1]++; });
+    for (uint32_t i = 0; i < n; ++i) net.fanStart[i + 1] += net.fanStart[i];
+    net.fanGate.assign(net.fanStart[n], 0);
+    std::vector<uint32_t> fill(net.fanStart.begin(), net.fanStart.end() - 1);
+    for (uint32_t gi = 0; gi < net.gates.size(); ++gi) {
+        net.forEachInput(net.gates[gi], [&](uint32_t s) { net.fanGate[fill[s]++] = gi; });
+    }
+}
+
+// Input support of every output, propagated in topological order as one
+// bitset (words of input indices) per signal. A feedback loop's outputs
+// get the union of what its gates read, and component instances map
+// their own nets' support.
+static void computeSupport(Net& net) {
+    const size_t words = (net.inputIds.size() + 63) / 64;
+    std::vector<uint64_t> sup(static_cast<size_t>(net.numSignals()) * words, 0);
+    auto of = [&](uint32_t s) { return sup.data() + static_cast<size_t>(s) * words; };
+    for (size_t i = 0; i < net.inputIds.size(); ++i) of(net.inputIds[i])[i / 64] |= 1ull << (i % 64);
+
+    std::vector<uint64_t> acc(words);
+    auto read = [&](uint32_t s) {
+        for (size_t w = 0; w < words; ++w) acc[w] |= of(s)[w];
     };
-    
-    return g;
+    auto write = [&](uint32_t s) {
+        for (size_t w = 0; w < words; ++w) of(s)[w] |= acc[w];
+    };
+    for (uint32_t gi = 0; gi < net.gates.size();) {
+        uint32_t end = gi + 1;
+        if (net.loopOf[gi] != kNoSignal) end = net.loops[net.loopOf[gi]].end;
+        if (end == gi + 1 && net.gates[gi].op == GateOp::Sub) {
+            const Net::SubInstance& inst = net.subs[net.gates[gi].sub];
+            const Net& sub = inst.net[0];
+            for (size_t k = 0; k < inst.outs.size(); ++k) {
+                std::fill(acc.begin(), acc.end(), 0);
+                for (uint32_t j : sub.outputSupport[k]) read(inst.ins[j]);
+                write(inst.outs[k]);
+            }
+            gi = end;
+            continue;
+        }
+        std::fill(acc.begin(), acc.end(), 0);
+        for (uint32_t g = gi; g < end; ++g) net.forEachInput(net.gates[g], read);
+        for (uint32_t g = gi; g < end; ++g) net.forEachOutput(net.gates[g], write);
+        gi = end;
+    }
+
+    net.outputSupport.assign(net.outputIds.size(), {});
+    for (size_t o = 0; o < net.outputIds.size(); ++o) {
+        const uint64_t* bits = of(net.outputIds[o]);
+        for (size_t i = 0; i < net.inputIds.size(); ++i) {
+            if ((bits[i / 64] >> (i % 64)) & 1) net.outputSupport[o].push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+// Orders gates by the strongly connected components of the gate graph
+// (Tarjan), in topological order of the components, and assigns levels.
+// Components with more than one gate, or a gate reading its own output,
+// are feedback loops; each occupies a contiguous range of gates and is the
+// only thing simulate() iterates to a fixed point.
+void levelizeNet(Net& net) {
+    buildFanout(net);
+    uint32_t n = static_cast<uint32_t>(net.gates.size());
+    std::vector<uint32_t> succStart(n + 1, 0), succ;
+    std::vector<uint8_t> readsSelf(n, 0);
+    for (uint32_t gi = 0; gi < n; ++gi) {
+        net.forEachOutput(net.gates[gi], [&](uint32_t s) {
+            for (uint32_t f = net.fanStart[s]; f < net.fanStart[s + 1]; ++f) {
+                succ.push_back(net.fanGate[f]);
+                if (net.fanGate[f] == gi) readsSelf[gi] = 1;
+            }
+        });
+        succStart[gi + 1] = static_cast<uint32_t>(succ.size());
+    }
+
+    // Iterative Tarjan; components come out sinks first.
+    std::vector<uint32_t> index(n, kNoSignal), low(n, 0), comp(n, kNoSignal), stack;
+    std::vector<std::pair<uint32_t, uint32_t>> calls;  // gate, next successor edge
+    std::vector<std::vector<uint32_t>> comps;
+    uint32_t counter = 0;
+    for (uint32_t root = 0; root < n; ++root) {
+        if (index[root] != kNoSignal) continue;
+        auto visit = [&](uint32_t v) {
+            index[v] = low[v] = counter++;
+            stack.push_back(v);
+            calls.push_back({v, succStart[v]});
+        };
+        visit(root);
+        while (!calls.empty()) {
+            uint32_t v = calls.back().first;
+            uint32_t e = calls.back().second;
+            if (e < succStart[v + 1]) {
+                calls.back().second++;
+                uint32_t w = succ[e];
+                if (index[w] == kNoSignal) visit(w);
+                else if (comp[w] == kNoSignal) low[v] = std::min(low[v], index[w]);
+                continue;
+            }
+            calls.pop_back();
+            if (!calls.empty()) low[calls.back().first] = std::min(low[calls.back().first], low[v]);
+            if (low[v] != index[v]) continue;
+            comps.emplace_back();
+            uint32_t w;
+            do {
+                w = stack.back();
+                stack.pop_back();
+                comp[w] = static_cast<uint32_t>(comps.size() - 1);
+                comps.back().push_back(w);
+            } while (w != v);
+        }
+    }
+
+    // Levels over the component DAG: every gate of a loop shares one level.
+    std::vector<uint32_t> compLevel(comps.size(), 1);
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    net.loops.clear();
+    net.loopOf.assign(n, kNoSignal);
+    for (size_t c = comps.size(); c-- > 0;) {
+        std::vector<uint32_t>& members = comps[c];
+        std::sort(members.begin(), members.end());  // loop gates iterate in netlist order
+        for (uint32_t gi : members) {
+            for (uint32_t e = succStart[gi]; e < succStart[gi + 1]; ++e) {
+                uint32_t r = comp[succ[e]];
+                if (r != c) compLevel[r] = std::max(compLevel[r], compLevel[c] + 1);
+            }
+        }
+        if (members.size() > 1 || readsSelf[members[0]]) {
+            Net::Loop loop;
+            loop.begin = static_cast<uint32_t>(order.size());
+            loop.end = loop.begin + static_cast<uint32_t>(members.size());
+            for (uint32_t k = loop.begin; k < loop.end; ++k) net.loopOf[k] = static_cast<uint32_t>(net.loops.size());
+            net.loops.push_back(loop);
+        }
+        order.insert(order.end(), members.begin(), members.end());
+    }
+    net.cyclic = !net.loops.empty();
+
+    std::vector<Net::Gate> sorted;
+    sorted.reserve(n);
+    net.level.clear();
+    for (uint32_t gi : order) {
+        sorted.push_back(net.gates[gi]);
+        net.level.push_back(compLevel[comp[gi]]);
+    }
+    net.gates = std::move(sorted);
+    net.events = Net::EventState();
+    buildFanout(net);
+    computeSupport(net);
+    compileBytecode(net);
 }
 
 Net buildNet(const AST& ast) {
     return buildNetWithComponents(ast, nullptr);
 }
 
-Net buildNetWithComponents(const AST& ast, ComponentLibrary* componentLib) {
+// Allocates parent signals for every gate output inside a component's net,
+// named after the instance so flattened signals stay traceable.
+static std::vector<uint32_t> inlineSignals(Net& net, const std::string& inst, const Net& sub) {
+    std::vector<uint32_t> map(sub.numSignals(), kNoSignal);
+    map[Net::kConst0] = Net::kConst0;
+    map[Net::kConst1] = Net::kConst1;
+    auto name = [&](uint32_t s) {
+        const std::string& n = sub.sigName[s];
+        return "part:" + inst + "/" + (n.rfind("part:", 0) == 0 ? n.substr(5) : n);
+    };
+    for (const auto& g : sub.gates) {
+        sub.forEachOutput(g, [&](uint32_t s) { map[s] = newSignal(net, name(s)); });
+    }
+    return map;
+}
+
+Net buildNetWithComponents(const AST& ast, ComponentLibrary* componentLib, const BuildOptions& options) {
     Net net;
     net.ast = ast;
-    for (auto& i : ast.inputs) net.val["inp:" + i] = 0;
-    for (auto& o : ast.outputs) net.val["out:" + o] = 0;
+    newSignal(net, "const:0");
+    newSignal(net, "const:1");
+    net.val[Net::kConst1] = 1;
+
+    PinTable pins;
+    for (auto& i : ast.inputs) {
+        auto it = pins.slot.find("inp:" + i);
+        uint32_t s = it != pins.slot.end() ? pins.sig[it->second] : newSignal(net, "inp:" + i);
+        pins.add("inp:" + i, s);
+        net.inputIds.push_back(s);
+    }
+    for (auto& o : ast.outputs) pins.add("out:" + o, kNoSignal);
+
+    // Resolve every part; a repeated part name replaces the earlier definition.
+    std::unordered_map<std::string, size_t> partIndex;
+    std::vector<std::pair<const AST::Part*, GateDef>> defs;
     for (auto& p : ast.parts) {
         GateDef g;
         std::string kindLower = p.kind;
@@ -182,62 +387,414 @@ Net buildNetWithComponents(const AST& ast, ComponentLibrary* componentLib) {
             }
         }
         
-        net.partDef[p.name] = g;
-        for (auto& ip : g.inPins) net.val[pinKey(p.name, ip)] = 0;
-        for (auto& op : g.outPins) net.val[pinKey(p.name, op)] = 0;
+        auto it = partIndex.find(p.name);
+        if (it != partIndex.end()) {
+            defs[it->second] = {&p, g};
+        } else {
+            partIndex[p.name] = defs.size();
+            defs.push_back({&p, g});
+        }
     }
+
+    auto componentOf = [&](const AST::Part* p) {
+        std::string kindLower = p->kind;
+        std::transform(kindLower.begin(), kindLower.end(), kindLower.begin(), ::tolower);
+        return componentLib->getComponent(kindLower);
+    };
+
+    // Component output pins of flattened instances alias whatever drives the
+    // output inside the component: an inlined gate, a constant, or (for
+    // pass-through wiring) the instance's own input pin.
+    std::vector<std::vector<uint32_t>> inSlots(defs.size()), outSigs(defs.size()), inlined(defs.size());
+    for (size_t i = 0; i < defs.size(); ++i) {
+        const auto& [p, g] = defs[i];
+        for (auto& ip : g.inPins) inSlots[i].push_back(pins.add(pinKey(p->name, ip), kNoSignal));
+        if (g.op == GateOp::Sub && options.flatten && options.useLuts && componentOf(p)->lut) {
+            for (auto& op : g.outPins) {
+                uint32_t s = newSignal(net, pinKey(p->name, op));
+                pins.add(pinKey(p->name, op), s);
+                outSigs[i].push_back(s);
+            }
+            continue;
+        }
+        if (g.op == GateOp::Sub && options.flatten) {
+            const Net& sub = componentOf(p)->net;
+            inlined[i] = inlineSignals(net, p->name, sub);
+            for (size_t o = 0; o < g.outPins.size(); ++o) {
+                uint32_t s = sub.outputIds[o];
+                uint32_t slot = pins.add(pinKey(p->name, g.outPins[o]), inlined[i][s]);
+                if (inlined[i][s] != kNoSignal) continue;
+                for (size_t k = 0; k < sub.inputIds.size(); ++k) {
+                    if (sub.inputIds[k] == s) pins.driver[slot] = inSlots[i][k];
+                }
+            }
+            continue;
+        }
+        for (auto& op : g.outPins) {
+            uint32_t s = newSignal(net, pinKey(p->name, op));
+            pins.add(pinKey(p->name, op), s);
+            outSigs[i].push_back(s);
+        }
+    }
+
     for (auto& w : ast.wires) {
-        std::string s = resolveSrc(ast, net.val, w.src);
-        std::string d = resolveDst(ast, net.val, w.dst);
-        net.fan[s].push_back(d);
+        std::string s = resolveSrc(ast, pins.slot, w.src);
+        std::string d = resolveDst(ast, pins.slot, w.dst);
+        pins.driver[pins.slot.at(d)] = pins.slot.at(s);
+    }
+
+    for (size_t i = 0; i < defs.size(); ++i) {
+        const auto& [p, g] = defs[i];
+        Net::Gate gate{g.op, Net::kConst0, Net::kConst0, kNoSignal, 0};
+        if (g.op == GateOp::Sub && options.flatten && options.useLuts && componentOf(p)->lut) {
+            std::vector<uint32_t> ins;
+            for (uint32_t s : inSlots[i]) ins.push_back(pins.signalOf(s));
+            for (size_t o = 0; o < outSigs[i].size(); ++o) {
+                gate.op = GateOp::Lut;
+                gate.out = outSigs[i][o];
+                gate.sub = static_cast<uint32_t>(net.luts.size());
+                net.luts.push_back({ins, componentOf(p)->lut, o});
+                net.gates.push_back(gate);
+            }
+            continue;
+        }
+        if (g.op == GateOp::Sub && options.flatten) {
+            const Net& sub = componentOf(p)->net;
+            std::vector<uint32_t>& map = inlined[i];
+            for (size_t k = 0; k < sub.inputIds.size(); ++k) map[sub.inputIds[k]] = pins.signalOf(inSlots[i][k]);
+            for (const auto& sg : sub.gates) {
+                Net::Gate copy = sg;
+                if (sg.op == GateOp::Sub) {
+                    Net::SubInstance inst = sub.subs[sg.sub];
+                    for (auto& s : inst.ins) s = map[s];
+                    for (auto& s : inst.outs) s = map[s];
+                    copy.sub = static_cast<uint32_t>(net.subs.size());
+                    net.subs.push_back(std::move(inst));
+                } else if (sg.op == GateOp::Lut) {
+                    Net::LutInstance lut = sub.luts[sg.sub];
+                    for (auto& s : lut.ins) s = map[s];
+                    copy.sub = static_cast<uint32_t>(net.luts.size());
+                    net.luts.push_back(std::move(lut));
+                } else {
+                    copy.in1 = map[sg.in1];
+                    copy.in2 = map[sg.in2];
+                }
+                copy.out = sg.out == kNoSignal ? kNoSignal : map[sg.out];
+                net.gates.push_back(copy);
+            }
+            continue;
+        }
+        if (g.op == GateOp::Sub) {
+            Net::SubInstance inst;
+            for (uint32_t s : inSlots[i]) inst.ins.push_back(pins.signalOf(s));
+            inst.outs = outSigs[i];
+            inst.net.push_back(componentOf(p)->net);
+            gate.sub = static_cast<uint32_t>(net.subs.size());
+            gate.out = inst.outs.empty() ? kNoSignal : inst.outs[0];
+            net.subs.push_back(std::move(inst));
+        } else {
+            gate.in1 = pins.signalOf(inSlots[i][0]);
+            if (inSlots[i].size() > 1) gate.in2 = pins.signalOf(inSlots[i][1]);
+            gate.out = outSigs[i][0];
+        }
+        net.gates.push_back(gate);
     }
+
+    for (auto& o : ast.outputs) net.outputIds.push_back(pins.signalOf(pins.slot.at("out:" + o)));
+    levelizeNet(net);
     return net;
 }
 
-std::unordered_map<std::string, int> simulate(Net& net, const std::unordered_map<std::string, int>& inVec) {
-    for (auto& [k, v] : inVec) net.val["inp:" + k] = v & 1;
-    bool changed = true;
-    int guard = 0;
-    while (changed && guard++ < 64) {
-        changed = false;
-        for (auto& kv : net.partDef) {
-            const std::string& name = kv.first;
-            const GateDef& g = kv.second;
-            std::unordered_map<std::string, int> pins;
-            for (auto& p : g.inPins) pins[p] = net.val[pinKey(name, p)] & 1;
-            auto outs = g.eval(pins);
-            for (auto& ov : outs) {
-                std::string key = pinKey(name, ov.first);
-                int nv = ov.second & 1;
-                if (net.val[key] != nv) {
-                    net.val[key] = nv;
-                    changed = true;
+static inline uint8_t evalGate(GateOp op, uint8_t a, uint8_t b) {
+    switch (op) {
+        case GateOp::Not: return a ^ 1;
+        case GateOp::And: return a & b;
+        case GateOp::Or: return a | b;
+        case GateOp::Xor: return a ^ b;
+        case GateOp::Nand: return (a & b) ^ 1;
+        case GateOp::Nor: return (a | b) ^ 1;
+        default: return 0;
+    }
+}
+
+// Evaluates one gate; returns true if any output signal changed.
+static bool stepGate(Net& net, const Net::Gate& g, std::vector<uint8_t>& scratch) {
+    if (g.op == GateOp::Lut) {
+        const Net::LutInstance& lut = net.luts[g.sub];
+        size_t row = 0;
+        for (size_t j = 0; j < lut.ins.size(); ++j) row |= static_cast<size_t>(net.val[lut.ins[j]]) << j;
+        uint8_t nv = (lut.bits()[row / 64] >> (row % 64)) & 1;
+        if (net.val[g.out] == nv) return false;
+        net.val[g.out] = nv;
+        return true;
+    }
+    if (g.op != GateOp::Sub) {
+        uint8_t nv = evalGate(g.op, net.val[g.in1], net.val[g.in2]);
+        if (net.val[g.out] == nv) return false;
+        net.val[g.out] = nv;
+        return true;
+    }
+    Net::SubInstance& inst = net.subs[g.sub];
+    size_t nin = inst.ins.size();
+    scratch.resize(nin + inst.outs.size());
+    for (size_t i = 0; i < nin; ++i) scratch[i] = net.val[inst.ins[i]];
+    simulate(inst.net[0], scratch.data(), scratch.data() + nin);
+    bool changed = false;
+    for (size_t i = 0; i < inst.outs.size(); ++i) {
+        uint8_t nv = scratch[nin + i];
+        if (net.val[inst.outs[i]] != nv) {
+            net.val[inst.outs[i]] = nv;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Iterates one feedback loop until a full pass over it changes nothing.
+static void settleLoop(Net& net, Net::Loop& loop, std::vector<uint8_t>& scratch) {
+    for (int pass = 0; pass < Net::kLoopPasses; ++pass) {
+        bool changed = false;
+        for (uint32_t i = loop.begin; i < loop.end; ++i) changed |= stepGate(net, net.gates[i], scratch);
+        if (!changed) return;
+    }
+    loop.oscillating = true;
+}
+
+static void simulateLevelized(Net& net, std::vector<uint8_t>& scratch) {
+    for (uint32_t i = 0; i < net.gates.size();) {
+        uint32_t l = net.loopOf[i];
+        if (l == kNoSignal) {
+            stepGate(net, net.gates[i++], scratch);
+            continue;
+        }
+        settleLoop(net, net.loops[l], scratch);
+        i = net.loops[l].end;
+    }
+}
+
+static void scheduleReaders(Net& net, uint32_t s) {
+    Net::EventState& ev = net.events;
+    for (uint32_t f = net.fanStart[s]; f < net.fanStart[s + 1]; ++f) {
+        uint32_t gi = net.fanGate[f];
+        if (ev.dirty[gi]) continue;
+        ev.dirty[gi] = 1;
+        ev.byLevel[net.level[gi]].push_back(gi);
+    }
+}
+
+// Applies new input values and propagates only through the fanout of the
+// inputs that changed, level by level. A gate outside loops is evaluated at
+// most once; the gates of a loop share a level, so they re-queue each other
+// in the same bucket until the loop settles or uses up the same budget as
+// the levelized fixed-point loop.
+static void simulateEvents(Net& net, const uint8_t* in, std::vector<uint8_t>& scratch) {
+    Net::EventState& ev = net.events;
+    if (!ev.settled) {
+        for (size_t i = 0; i < net.inputIds.size(); ++i) net.val[net.inputIds[i]] = in[i] & 1;
+        simulateLevelized(net, scratch);
+        uint32_t maxLevel = 0;
+        for (uint32_t l : net.level) maxLevel = std::max(maxLevel, l);
+        ev.dirty.assign(net.gates.size(), 0);
+        ev.byLevel.resize(maxLevel + 1);
+        ev.settled = true;
+        return;
+    }
+
+    for (size_t i = 0; i < net.inputIds.size(); ++i) {
+        uint32_t s = net.inputIds[i];
+        if (net.val[s] == (in[i] & 1)) continue;
+        net.val[s] = in[i] & 1;
+        scheduleReaders(net, s);
+    }
+    ev.loopEvals.assign(net.loops.size(), 0);
+    for (auto& bucket : ev.byLevel) {
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            uint32_t gi = bucket[i];
+            ev.dirty[gi] = 0;
+            uint32_t l = net.loopOf[gi];
+            if (l != kNoSignal) {
+                Net::Loop& loop = net.loops[l];
+                if (++ev.loopEvals[l] > size_t{Net::kLoopPasses} * (loop.end - loop.begin)) {
+                    loop.oscillating = true;
+                    continue;
                 }
             }
+            const Net::Gate& g = net.gates[gi];
+            if (!stepGate(net, g, scratch)) continue;
+            net.forEachOutput(g, [&](uint32_t s) { scheduleReaders(net, s); });
         }
-        for (auto& e : net.fan) {
-            int sv = net.val[e.first] & 1;
-            for (auto& d : e.second) {
-                if (net.val[d] != sv) {
-                    net.val[d] = sv;
-                    changed = true;
-                }
+        bucket.clear();
+    }
+}
+
+void simulate(Net& net, const uint8_t* in, uint8_t* out) {
+    std::vector<uint8_t> scratch;
+    if (net.mode == SimMode::EventDriven) {
+        simulateEvents(net, in, scratch);
+    } else if (net.mode == SimMode::Bytecode) {
+        for (size_t i = 0; i < net.inputIds.size(); ++i) net.val[net.inputIds[i]] = in[i] & 1;
+        runBytecode(net, scratch);
+    } else {
+        for (size_t i = 0; i < net.inputIds.size(); ++i) net.val[net.inputIds[i]] = in[i] & 1;
+        simulateLevelized(net, scratch);
+    }
+    for (size_t i = 0; i < net.outputIds.size(); ++i) out[i] = net.val[net.outputIds[i]];
+}
+
+std::unordered_map<std::string, int> simulate(Net& net, const std::unordered_map<std::string, int>& inVec) {
+    std::vector<uint8_t> in(net.inputIds.size()), out(net.outputIds.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        auto it = inVec.find(net.ast.inputs[i]);
+        in[i] = it != inVec.end() ? it->second & 1 : net.val[net.inputIds[i]];
+    }
+    simulate(net, in.data(), out.data());
+    std::unordered_map<std::string, int> res;
+    for (size_t i = 0; i < out.size(); ++i) res[net.ast.outputs[i]] = out[i];
+    return res;
+}
+
+// Index of each named output in net.outputIds; throws for unknown names.
+static std::vector<size_t> outputIndices(const Net& net, const std::vector<std::string>& outputs) {
+    std::vector<size_t> idx;
+    for (const auto& name : outputs) {
+        auto it = std::find(net.ast.outputs.begin(), net.ast.outputs.end(), name);
+        if (it == net.ast.outputs.end()) throw std::runtime_error("Unknown output: " + name);
+        idx.push_back(static_cast<size_t>(it - net.ast.outputs.begin()));
+    }
+    return idx;
+}
+
+// Marks the gates in the transitive fan-in of the given outputs. One
+// backward pass suffices because gates are in topological order; a loop
+// is kept or dropped as a whole, since its gates feed each other.
+static std::vector<uint8_t> coneGates(const Net& net, const std::vector<size_t>& outputs) {
+    std::vector<uint8_t> need(net.numSignals(), 0), live(net.gates.size(), 0);
+    for (size_t o : outputs) need[net.outputIds[o]] = 1;
+    for (uint32_t end = static_cast<uint32_t>(net.gates.size()); end > 0;) {
+        uint32_t l = net.loopOf[end - 1];
+        uint32_t begin = l == kNoSignal ? end - 1 : net.loops[l].begin;
+        bool used = false;
+        for (uint32_t gi = begin; gi < end; ++gi) {
+            net.forEachOutput(net.gates[gi], [&](uint32_t s) { used |= need[s] != 0; });
+        }
+        if (used) {
+            for (uint32_t gi = begin; gi < end; ++gi) {
+                live[gi] = 1;
+                net.forEachInput(net.gates[gi], [&](uint32_t s) { need[s] = 1; });
             }
         }
+        end = begin;
     }
-    std::unordered_map<std::string, int> out;
-    for (auto& o : net.ast.outputs) out[o] = net.val["out:" + o] & 1;
-    return out;
+    return live;
+}
+
+Net coneNet(const Net& net, const std::vector<std::string>& outputs) {
+    std::vector<size_t> idx = outputIndices(net, outputs);
+    std::vector<uint8_t> live = coneGates(net, idx);
+
+    Net cone;
+    cone.mode = net.mode;
+    cone.ast = net.ast;
+    cone.ast.outputs = outputs;
+    std::vector<uint32_t> map(net.numSignals(), kNoSignal);
+    auto keep = [&](uint32_t s) {
+        if (map[s] == kNoSignal) {
+            map[s] = cone.numSignals();
+            cone.sigName.push_back(net.sigName[s]);
+            cone.val.push_back(net.val[s]);
+        }
+        return map[s];
+    };
+    keep(Net::kConst0);
+    keep(Net::kConst1);
+    for (uint32_t s : net.inputIds) cone.inputIds.push_back(keep(s));
+    for (uint32_t gi = 0; gi < net.gates.size(); ++gi) {
+        if (live[gi]) net.forEachOutput(net.gates[gi], keep);
+    }
+    for (uint32_t gi = 0; gi < net.gates.size(); ++gi) {
+        if (!live[gi]) continue;
+        Net::Gate g = net.gates[gi];
+        if (g.op == GateOp::Sub) {
+            Net::SubInstance inst = net.subs[g.sub];
+            for (auto& s : inst.ins) s = keep(s);
+            for (auto& s : inst.outs) s = keep(s);
+            g.sub = static_cast<uint32_t>(cone.subs.size());
+            cone.subs.push_back(std::move(inst));
+        } else if (g.op == GateOp::Lut) {
+            Net::LutInstance lut = net.luts[g.sub];
+            for (auto& s : lut.ins) s = keep(s);
+            g.sub = static_cast<uint32_t>(cone.luts.size());
+            cone.luts.push_back(std::move(lut));
+        } else {
+            g.in1 = keep(g.in1);
+            g.in2 = keep(g.in2);
+        }
+        if (g.out != kNoSignal) g.out = keep(g.out);
+        cone.gates.push_back(g);
+    }
+    for (size_t o : idx) cone.outputIds.push_back(keep(net.outputIds[o]));
+    levelizeNet(cone);
+    return cone;
 }
 
-std::vector<std::unordered_map<std::string, int>> allCombos(const std::vector<std::string>& names) {
-    std::vector<std::unordered_map<std::string, int>> v;
-    int n = static_cast<int>(names.size());
-    for (int m = 0; m < (1 << n); ++m) {
-        std::unordered_map<std::string, int> t;
-        for (int i = 0; i < n; ++i) t[names[i]] = (m >> i) & 1;
-        v.push_back(std::move(t));
+std::unordered_map<std::string, int> simulate(Net& net, const std::unordered_map<std::string, int>& inVec,
+                                              const std::vector<std::string>& outputs) {
+    std::vector<size_t> idx = outputIndices(net, outputs);
+    std::vector<uint8_t> live = coneGates(net, idx);
+    for (size_t i = 0; i < net.inputIds.size(); ++i) {
+        auto it = inVec.find(net.ast.inputs[i]);
+        if (it != inVec.end()) net.val[net.inputIds[i]] = it->second & 1;
+    }
+    std::vector<uint8_t> scratch;
+    for (uint32_t i = 0; i < net.gates.size();) {
+        uint32_t l = net.loopOf[i];
+        if (l == kNoSignal) {
+            if (live[i]) stepGate(net, net.gates[i], scratch);
+            ++i;
+            continue;
+        }
+        if (live[i]) settleLoop(net, net.loops[l], scratch);
+        i = net.loops[l].end;
     }
-    return v;
+    // Signals outside the cone are stale now; the next event-driven call
+    // starts over with a full evaluation
+    net.events.settled = false;
+    std::unordered_map<std::string, int> res;
+    for (size_t o : idx) res[net.ast.outputs[o]] = net.val[net.outputIds[o]];
+    return res;
 }
 
+std::vector<std::string> oscillatingParts(const Net& net) {
+    std::vector<std::string> parts;
+    auto partOf = [&](uint32_t s) {
+        const std::string& n = net.sigName[s];
+        size_t from = n.rfind("part:", 0) == 0 ? 5 : 0;
+        return n.substr(from, n.rfind('.') - from);
+    };
+    for (const auto& loop : net.loops) {
+        if (!loop.oscillating) continue;
+        for (uint32_t i = loop.begin; i < loop.end; ++i) {
+            net.forEachOutput(net.gates[i], [&](uint32_t s) {
+                if (parts.empty() || parts.back() != partOf(s)) parts.push_back(partOf(s));
+            });
+        }
+    }
+    for (const auto& g : net.gates) {
+        if (g.op != GateOp::Sub) continue;
+        // Instances are named through their output signals; one without
+        // outputs has nothing to name it by, so its parts go unprefixed
+        const Net::SubInstance& sub = net.subs[g.sub];
+        std::string inst = sub.outs.empty() ? "" : partOf(sub.outs[0]) + "/";
+        for (const auto& p : oscillatingParts(sub.net[0])) parts.push_back(inst + p);
+    }
+    return parts;
+}
+
+InputVectors::InputVectors(size_t inputs) : InputVectors(inputs, 0, inputs < 64 ? 1ull << inputs : 0) {}
+
+InputVectors::InputVectors(size_t inputs, uint64_t first, uint64_t count)
+    : inputs_(inputs), first_(first), count_(count) {
+    if (inputs >= 64) throw std::runtime_error("Too many inputs to enumerate: " + std::to_string(inputs));
+    uint64_t rows = 1ull << inputs;
+    if (first > rows || count > rows - first) throw std::runtime_error("Input vector range out of bounds");
+}
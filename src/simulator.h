@@ -4,11 +4,21 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
-#include <functional>
+#include <cstdint>
+#include <memory>
+
+enum class GateOp : uint8_t { Not, And, Or, Xor, Nand, Nor, Sub, Lut };
+
+// Levelized: every call evaluates all gates once in topological order.
+// EventDriven: after the first call, only gates in the transitive fanout
+// of inputs that changed since the previous call are re-evaluated.
+// Bytecode: like Levelized, but runs the linear program levelizeNet emits
+// (Net::code) on the threaded interpreter in bytecode.cpp.
+enum class SimMode : uint8_t { Levelized, EventDriven, Bytecode };
 
 struct GateDef {
     std::vector<std::string> inPins, outPins;
-    std::function<std::unordered_map<std::string, int>(const std::unordered_map<std::string, int>&)> eval;
+    GateOp op;
 };
 
 struct AST {
@@ -19,18 +29,182 @@ struct AST {
     std::vector<Wire> wires;
 };
 
+// Compiled netlist. Wires are resolved at build time, so every signal
+// (constant, circuit input or gate output) has a dense 32-bit id and its
+// value lives in the flat `val` array. Signals 0 and 1 are the constants.
 struct Net {
-    std::unordered_map<std::string, int> val;
-    std::unordered_map<std::string, std::vector<std::string>> fan;
-    std::unordered_map<std::string, GateDef> partDef;
+    static constexpr uint32_t kConst0 = 0;
+    static constexpr uint32_t kConst1 = 1;
+    static constexpr uint32_t kNoSignal = UINT32_MAX;
+
+    struct Gate {
+        GateOp op;
+        uint32_t in1, in2;  // driving signal ids (in2 unused for Not)
+        uint32_t out;       // signal id written by this gate
+        uint32_t sub;       // index into subs (GateOp::Sub) or luts (GateOp::Lut)
+    };
+
+    // Custom component instance, simulated through its own compiled net.
+    struct SubInstance {
+        std::vector<uint32_t> ins, outs;
+        std::vector<Net> net;  // exactly one element; vector allows the recursive type
+    };
+
+    // One output column of a component's precomputed truth table. Row r
+    // (bit j of r = value of ins[j]) is bit r of table[column * words + r / 64].
+    struct LutInstance {
+        std::vector<uint32_t> ins;
+        std::shared_ptr<const std::vector<uint64_t>> table;
+        size_t column;
+
+        size_t words() const { return ins.size() > 6 ? (size_t{1} << ins.size()) / 64 : 1; }
+        const uint64_t* bits() const { return table->data() + column * words(); }
+    };
+
+    // Feedback loop: a strongly connected component of the gate graph with
+    // more than one gate, or a gate reading its own output. Its gates are
+    // the contiguous range gates[begin, end) and share one level.
+    struct Loop {
+        uint32_t begin, end;
+        bool oscillating = false;  // some simulate() call hit the pass limit
+    };
+    static constexpr int kLoopPasses = 64;  // passes over a loop before giving up
+
+    // Activity tracking for SimMode::EventDriven.
+    struct EventState {
+        bool settled = false;                       // val reflects a full evaluation
+        std::vector<uint8_t> dirty;                 // per gate: already queued
+        std::vector<std::vector<uint32_t>> byLevel; // queued gates by level
+        std::vector<size_t> loopEvals;              // per loop: evaluations this call
+    };
+
+    // One bytecode instruction: op is a GateOp value or the section end
+    // marker; a, b and out are signal ids (a indexes subs/luts for Sub/Lut).
+    struct Instr {
+        uint32_t op, a, b, out;
+    };
+
+    SimMode mode = SimMode::Levelized;
+    EventState events;
+    std::vector<Instr> code;            // gates in order, loops bracketed, see bytecode.cpp
+    std::vector<uint8_t> val;
+    std::vector<Gate> gates;            // topological order, see levelize()
+    std::vector<uint32_t> level;        // per gate: 1 + deepest driving gate (loops count as one)
+    std::vector<Loop> loops;            // in topological order
+    std::vector<uint32_t> loopOf;       // per gate: index into loops, or kNoSignal
+    bool cyclic = false;                // !loops.empty()
+    std::vector<SubInstance> subs;
+    std::vector<LutInstance> luts;
+    std::vector<uint32_t> inputIds, outputIds;  // in AST order
+    // Per output: indices into inputIds of the inputs in its fan-in cone,
+    // ascending. Structural, so an input may be listed without mattering.
+    std::vector<std::vector<uint32_t>> outputSupport;
+    std::vector<uint32_t> fanStart, fanGate;    // CSR: signal -> reading gates
+    std::vector<std::string> sigName;           // for diagnostics
     AST ast;
+
+    uint32_t numSignals() const { return static_cast<uint32_t>(val.size()); }
+
+    template <typename Fn>
+    void forEachInput(const Gate& g, Fn&& fn) const {
+        if (g.op == GateOp::Sub) {
+            for (uint32_t s : subs[g.sub].ins) fn(s);
+        } else if (g.op == GateOp::Lut) {
+            for (uint32_t s : luts[g.sub].ins) fn(s);
+        } else {
+            fn(g.in1);
+            if (g.op != GateOp::Not) fn(g.in2);
+        }
+    }
+
+    template <typename Fn>
+    void forEachOutput(const Gate& g, Fn&& fn) const {
+        if (g.op == GateOp::Sub) {
+            for (uint32_t s : subs[g.sub].outs) fn(s);
+        } else if (g.out != kNoSignal) {
+            fn(g.out);
+        }
+    }
+};
+
+// Options for buildNetWithComponents.
+struct BuildOptions {
+    // Inline custom components into the parent netlist (signals are named
+    // "part:inst/inner.pin"). When false each instance stays a GateOp::Sub
+    // gate simulated through its own Net, which is easier to inspect.
+    bool flatten = true;
+    // Evaluate flattened instances of components that carry a precomputed
+    // truth table (see ComponentLibrary::setLutMaxInputs) as GateOp::Lut
+    // gates, one per output, instead of inlining their gates.
+    bool useLuts = true;
 };
 
 AST parseHDL(const std::string& src);
+// Re-sorts gates topologically, recomputes levels, fanout, output support and bytecode. Call after
+// editing net.gates (e.g. from an optimization pass).
+void levelizeNet(Net& net);
 Net buildNet(const AST& ast);
-Net buildNetWithComponents(const AST& ast, class ComponentLibrary* componentLib);
+Net buildNetWithComponents(const AST& ast, class ComponentLibrary* componentLib,
+                           const BuildOptions& options = BuildOptions());
 std::unordered_map<std::string, int> simulate(Net& net, const std::unordered_map<std::string, int>& inVec);
-std::vector<std::unordered_map<std::string, int>> allCombos(const std::vector<std::string>& names);
+// Id-based variant: in/out hold one bit per entry of net.inputIds/net.outputIds.
+void simulate(Net& net, const uint8_t* in, uint8_t* out);
+// Evaluates only the gates in the fan-in cones of the named outputs and
+// returns just those. Latch state in the cone carries over as usual.
+// Throws for unknown outputs.
+std::unordered_map<std::string, int> simulate(Net& net, const std::unordered_map<std::string, int>& inVec,
+                                              const std::vector<std::string>& outputs);
+// A net with the named outputs only, in that order, holding the gates in
+// their fan-in cones and nothing else. Every input is kept, so rows and
+// input vectors mean the same as for net. Throws for unknown outputs.
+Net coneNet(const Net& net, const std::vector<std::string>& outputs);
+// Parts (hierarchical "inst/part" inside sub-instances, plain "part" in
+// instances without outputs to name them by) whose feedback loop failed
+// to settle within Net::kLoopPasses in some simulate() call.
+std::vector<std::string> oscillatingParts(const Net& net);
+// One vector of the exhaustive enumeration: input i takes bit i of row.
+struct InputVector {
+    uint64_t row;
 
-#endif
+    int operator[](size_t i) const { return i < 64 ? static_cast<int>((row >> i) & 1) : 0; }
+    // Writes inputs 0..n-1 as one byte each (the layout simulate() takes).
+    void unpack(uint8_t* in, size_t n) const {
+        for (size_t i = 0; i < n; ++i) in[i] = static_cast<uint8_t>((*this)[i]);
+    }
+};
+
+// Lazy range over rows [first, first + count) of the 2^inputs input
+// vectors, in row order. Nothing is materialized: iterating costs one
+// counter increment per vector. Throws for 64 or more inputs, whose row
+// count does not fit the 64-bit counter.
+class InputVectors {
+public:
+    class iterator {
+    public:
+        explicit iterator(uint64_t row) : row_(row) {}
+        InputVector operator*() const { return {row_}; }
+        iterator& operator++() {
+            ++row_;
+            return *this;
+        }
+        bool operator==(const iterator& o) const { return row_ == o.row_; }
+        bool operator!=(const iterator& o) const { return row_ != o.row_; }
 
+    private:
+        uint64_t row_;
+    };
+
+    explicit InputVectors(size_t inputs);
+    InputVectors(size_t inputs, uint64_t first, uint64_t count);
+
+    iterator begin() const { return iterator(first_); }
+    iterator end() const { return iterator(first_ + count_); }
+    uint64_t size() const { return count_; }
+    size_t inputs() const { return inputs_; }
+
+private:
+    size_t inputs_;
+    uint64_t first_, count_;
+};
+
+#endif
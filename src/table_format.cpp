@@ -0,0 +1,84 @@
+#include "table_format.h"
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+bool tableFormatByName(const std::string& name, TableFormat& format) {
+    if (name == "text") format = TableFormat::Text;
+    else if (name == "csv") format = TableFormat::Csv;
+    else if (name == "pla") format = TableFormat::Pla;
+    else if (name == "bin") format = TableFormat::Bin;
+    else return false;
+    return true;
+}
+
+RowFormatter::RowFormatter(TableFormat format, const std::vector<std::string>& inputs,
+                           const std::vector<std::string>& outputs) {
+    auto digit = [&](std::vector<uint32_t>& pos) {
+        pos.push_back(static_cast<uint32_t>(line_.size()));
+        line_ += '0';
+    };
+    switch (format) {
+        case TableFormat::Text:
+            line_ = "in {";
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                line_ += (i ? "," : "") + inputs[i] + ":";
+                digit(inPos_);
+            }
+            line_ += "} -> out {";
+            for (size_t o = 0; o < outputs.size(); ++o) {
+                line_ += (o ? "," : "") + outputs[o] + ":";
+                digit(outPos_);
+            }
+            line_ += "}";
+            break;
+        case TableFormat::Csv:
+            for (size_t i = 0; i < inputs.size() + outputs.size(); ++i) {
+                if (i) header_ += ',', line_ += ',';
+                header_ += i < inputs.size() ? inputs[i] : outputs[i - inputs.size()];
+                digit(i < inputs.size() ? inPos_ : outPos_);
+            }
+            header_ += '\n';
+            break;
+        case TableFormat::Pla:
+            header_ = ".i " + std::to_string(inputs.size()) + "\n.o " + std::to_string(outputs.size()) + "\n.ilb";
+            for (const auto& name : inputs) header_ += " " + name;
+            header_ += "\n.ob";
+            for (const auto& name : outputs) header_ += " " + name;
+            header_ += "\n.type fr\n.p " + std::to_string(1ull << inputs.size()) + "\n";
+            footer_ = ".e\n";
+            for (size_t i = 0; i < inputs.size(); ++i) digit(inPos_);
+            line_ += ' ';
+            for (size_t o = 0; o < outputs.size(); ++o) digit(outPos_);
+            break;
+        case TableFormat::Bin:
+            throw std::runtime_error("Binary tables are not formatted as rows");
+    }
+    line_ += '\n';
+}
+
+void RowFormatter::format(const TruthBlock& block, std::string& buf) const {
+    const size_t len = line_.size();
+    buf.resize(block.count * len);
+    char* p = &buf[0];
+    const uint64_t* outs = block.outs->data();
+    for (uint64_t k = 0; k < block.count; ++k, p += len) {
+        uint64_t row = block.base + k;
+        std::memcpy(p, line_.data(), len);
+        for (size_t i = 0; i < inPos_.size(); ++i) p[inPos_[i]] = static_cast<char>('0' + ((row >> i) & 1));
+        for (size_t o = 0; o < outPos_.size(); ++o) {
+            p[outPos_[o]] = static_cast<char>('0' + ((outs[o * block.words + k / 64] >> (k % 64)) & 1));
+        }
+    }
+}
+
+void writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throw std::runtime_error(std::string("Cannot write output: ") + std::strerror(errno));
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
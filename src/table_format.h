@@ -0,0 +1,42 @@
+#ifndef TABLE_FORMAT_H
+#define TABLE_FORMAT_H
+
+#include "bitsim.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Output formats of `minlab file.hdl`:
+//   Text  in {a:0,b:1} -> out {s:1}   (the original format)
+//   Csv   a header line of port names, then one line of digits per row
+//   Pla   Berkeley PLA (.i/.o/.ilb/.ob/.type fr/.p ... .e), inputs then outputs
+//   Bin   packed columns, see truth_file.h
+enum class TableFormat { Text, Csv, Pla, Bin };
+
+bool tableFormatByName(const std::string& name, TableFormat& format);
+
+// Formats rows of a text format. Every row of a table has the same shape,
+// so a template line is built once and each row is a copy of it with its
+// digits filled in.
+class RowFormatter {
+public:
+    RowFormatter(TableFormat format, const std::vector<std::string>& inputs,
+                 const std::vector<std::string>& outputs);
+
+    // Text written before the first and after the last row.
+    const std::string& header() const { return header_; }
+    const std::string& footer() const { return footer_; }
+
+    // Replaces buf with block's rows. Const, so enumeration workers can
+    // share one formatter.
+    void format(const TruthBlock& block, std::string& buf) const;
+
+private:
+    std::string line_, header_, footer_;
+    std::vector<uint32_t> inPos_, outPos_;  // offsets of each port's digit in line_
+};
+
+// Writes all of data to fd, retrying short writes; throws on error.
+void writeAll(int fd, const char* data, size_t size);
+
+#endif
@@ -0,0 +1,173 @@
+#include "truth_file.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+const char kMagic[4] = {'M', 'L', 'T', 'T'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kAlign = 64;
+
+uint64_t littleEndian(uint64_t x) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(x);
+#else
+    return x;
+#endif
+}
+
+void putInt(std::string& s, uint64_t x, int bytes) {
+    for (int i = 0; i < bytes; ++i) s += static_cast<char>((x >> (8 * i)) & 0xFF);
+}
+
+uint64_t getInt(const unsigned char* p, int bytes) {
+    uint64_t x = 0;
+    for (int i = 0; i < bytes; ++i) x |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return x;
+}
+
+// Fixed part of the header: magic, version, port counts, rows, data offset
+constexpr size_t kFixedHeader = 4 + 4 + 4 + 4 + 8 + 8;
+}
+
+TruthFileWriter::TruthFileWriter(int fd, const std::vector<std::string>& inputs,
+                                 const std::vector<std::string>& outputs)
+    : fd_(fd), outputs_(outputs.size()) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        throw std::runtime_error("Binary truth tables must be written to a regular file");
+    }
+    if (inputs.size() >= 64) throw std::runtime_error("Too many inputs to enumerate: " + std::to_string(inputs.size()));
+    uint64_t rows = 1ull << inputs.size();
+    columnWords_ = (rows + 63) / 64;
+
+    std::string names;
+    for (const auto* ports : {&inputs, &outputs}) {
+        for (const auto& name : *ports) {
+            putInt(names, name.size(), 4);
+            names += name;
+        }
+    }
+    offset_ = (kFixedHeader + names.size() + kAlign - 1) / kAlign * kAlign;
+
+    std::string header(kMagic, sizeof(kMagic));
+    putInt(header, kVersion, 4);
+    putInt(header, inputs.size(), 4);
+    putInt(header, outputs.size(), 4);
+    putInt(header, rows, 8);
+    putInt(header, offset_, 8);
+    header += names;
+    header.resize(offset_, '\0');
+    if (ftruncate(fd_, 0) != 0) throw std::runtime_error(std::string("Cannot write table: ") + std::strerror(errno));
+    writeAt(header.data(), header.size(), 0);
+}
+
+void TruthFileWriter::pack(const TruthBlock& block, std::string& buf) {
+    size_t outputs = block.outs->size() / block.words;
+    size_t words = static_cast<size_t>((block.count + 63) / 64);
+    uint64_t tail = block.count % 64 ? (1ull << (block.count % 64)) - 1 : ~0ull;
+    buf.resize(outputs * words * 8);
+    char* p = &buf[0];
+    for (size_t o = 0; o < outputs; ++o) {
+        const uint64_t* col = block.outs->data() + o * block.words;
+        for (size_t w = 0; w < words; ++w, p += 8) {
+            uint64_t x = littleEndian(w + 1 == words ? col[w] & tail : col[w]);
+            std::memcpy(p, &x, 8);
+        }
+    }
+}
+
+void TruthFileWriter::append(const std::string& buf) {
+    if (outputs_ == 0) return;
+    size_t words = buf.size() / 8 / outputs_;
+    if (written_ + words > columnWords_) throw std::runtime_error("Truth table block past the last row");
+    for (size_t o = 0; o < outputs_; ++o) {
+        writeAt(buf.data() + o * words * 8, words * 8, offset_ + (o * columnWords_ + written_) * 8);
+    }
+    written_ += words;
+}
+
+void TruthFileWriter::finish() {
+    if (outputs_ > 0 && written_ != columnWords_) throw std::runtime_error("Truth table is incomplete");
+}
+
+void TruthFileWriter::writeAt(const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd_, data, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throw std::runtime_error(std::string("Cannot write table: ") + std::strerror(errno));
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+}
+
+TruthFile::TruthFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kFixedHeader)) {
+        close(fd);
+        throw std::runtime_error("Not a truth table file: " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    map_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        throw std::runtime_error("Cannot map " + path);
+    }
+
+    try {
+        const auto* p = static_cast<const unsigned char*>(map_);
+        if (std::memcmp(p, kMagic, sizeof(kMagic)) != 0) throw std::runtime_error("Not a truth table file: " + path);
+        if (getInt(p + 4, 4) != kVersion) throw std::runtime_error("Unsupported truth table version: " + path);
+        uint64_t nin = getInt(p + 8, 4), nout = getInt(p + 12, 4);
+        rows_ = getInt(p + 16, 8);
+        uint64_t offset = getInt(p + 24, 8);
+        if (nin >= 64 || rows_ != 1ull << nin || offset % kAlign != 0 || offset > size_ ||
+            (size_ - offset) / 8 / columnWords() < nout) {
+            throw std::runtime_error("Corrupt truth table file: " + path);
+        }
+        size_t pos = kFixedHeader;
+        for (uint64_t i = 0; i < nin + nout; ++i) {
+            if (pos + 4 > offset) throw std::runtime_error("Corrupt truth table file: " + path);
+            uint64_t len = getInt(p + pos, 4);
+            pos += 4;
+            if (len > offset - pos) throw std::runtime_error("Corrupt truth table file: " + path);
+            (i < nin ? inputs_ : outputs_).emplace_back(reinterpret_cast<const char*>(p + pos), len);
+            pos += len;
+        }
+        data_ = reinterpret_cast<const uint64_t*>(p + offset);
+    } catch (...) {
+        munmap(map_, size_);
+        throw;
+    }
+}
+
+TruthFile::~TruthFile() {
+    if (map_) munmap(map_, size_);
+}
+
+int TruthFile::bit(size_t o, uint64_t row) const {
+    return static_cast<int>((littleEndian(column(o)[row / 64]) >> (row % 64)) & 1);
+}
+
+uint64_t countDifferences(const uint64_t* a, const uint64_t* b, size_t words, uint64_t& first) {
+    uint64_t count = 0;
+    bool found = false;
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t d = littleEndian(a[w] ^ b[w]);
+        if (!d) continue;
+        if (!found) {
+            first = 64 * w + static_cast<uint64_t>(__builtin_ctzll(d));
+            found = true;
+        }
+        count += static_cast<uint64_t>(__builtin_popcountll(d));
+    }
+    return count;
+}
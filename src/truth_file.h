@@ -0,0 +1,74 @@
+#ifndef TRUTH_FILE_H
+#define TRUTH_FILE_H
+
+#include "bitsim.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary truth tables (minlab --format=bin). Everything is little-endian:
+//
+//   "MLTT"  uint32 version  uint32 inputs  uint32 outputs
+//   uint64 rows  uint64 data offset
+//   per port, inputs first: uint32 length, name bytes
+//   zero padding up to the data offset (a multiple of 64)
+//   per output: ceil(rows / 64) uint64 words, bit r holding row r
+//
+// Rows are numbered as in InputVectors, so the inputs are implied and only
+// the output columns are stored. Column bits past the last row are zero.
+
+// Streams a table to a regular file. The header is written up front and
+// each block's column slices are written in place, so the file can be
+// produced in row order without holding more than one block.
+class TruthFileWriter {
+public:
+    // fd must be a regular file (columns are written at their offsets);
+    // throws otherwise.
+    TruthFileWriter(int fd, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs);
+
+    // Serializes block's column slices into buf for append(). Safe to call
+    // from enumeration workers.
+    static void pack(const TruthBlock& block, std::string& buf);
+    // Writes the next block packed by pack(); blocks must arrive in row order.
+    void append(const std::string& buf);
+    // Throws unless every row has been written.
+    void finish();
+
+private:
+    int fd_;
+    size_t outputs_;
+    uint64_t offset_, columnWords_, written_ = 0;
+
+    void writeAt(const char* data, size_t size, uint64_t offset);
+};
+
+// Read-only view of a table file, mapped into memory.
+class TruthFile {
+public:
+    // Throws if the file cannot be mapped or is not a valid table.
+    explicit TruthFile(const std::string& path);
+    ~TruthFile();
+    TruthFile(const TruthFile&) = delete;
+    TruthFile& operator=(const TruthFile&) = delete;
+
+    const std::vector<std::string>& inputs() const { return inputs_; }
+    const std::vector<std::string>& outputs() const { return outputs_; }
+    uint64_t rows() const { return rows_; }
+    size_t columnWords() const { return static_cast<size_t>((rows_ + 63) / 64); }
+    // Output o's column as stored, i.e. little-endian words.
+    const uint64_t* column(size_t o) const { return data_ + o * columnWords(); }
+    int bit(size_t o, uint64_t row) const;
+
+private:
+    void* map_ = nullptr;
+    size_t size_ = 0;
+    std::vector<std::string> inputs_, outputs_;
+    uint64_t rows_ = 0;
+    const uint64_t* data_ = nullptr;
+};
+
+// Number of rows on which two stored columns differ; first receives the
+// lowest such row (untouched when there is none).
+uint64_t countDifferences(const uint64_t* a, const uint64_t* b, size_t words, uint64_t& first);
+
+#endif
@@ -14,7 +14,7 @@ cd "$PROJECT_ROOT"
 echo "Building test executables..."
 cd "$BUILD_DIR"
 cmake .. > /dev/null 2>&1
-make test-ui-controls test-editor-integration > /dev/null 2>&1
+make test-ui-controls test-editor-integration test-simulator > /dev/null 2>&1
 
 echo ""
 echo "=========================================="
@@ -28,6 +28,12 @@ echo "Running Editor Integration Tests"
 echo "=========================================="
 ./test-editor-integration
 
+echo ""
+echo "=========================================="
+echo "Running Simulator Tests"
+echo "=========================================="
+./test-simulator
+
 echo ""
 echo "=========================================="
 echo "All tests completed!"
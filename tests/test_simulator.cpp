@@ -0,0 +1,1250 @@
+#include "../src/simulator.h"
+#include "../src/component_library.h"
+#include "../src/bitsim.h"
+#include "../src/gate_kernels.h"
+#include "../src/net_optimizer.h"
+#include "../src/aig.h"
+#include "../src/native.h"
+#include "../src/truth_file.h"
+#include "../src/table_format.h"
+#include "../src/game.h"
+#include "../src/cone_table.h"
+#include "../src/sat.h"
+#include "../src/equivalence.h"
+#include "../src/bdd.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Functional tests for the HDL parser and simulator.
+// Expected values are computed from plain C++ reference functions.
+
+static int g_failures = 0;
+
+static void printResult(const std::string& testName, bool passed, const std::string& details = "") {
+    std::cout << (passed ? "[PASS]" : "[FAIL]") << " " << testName;
+    if (!details.empty()) {
+        std::cout << " - " << details;
+    }
+    std::cout << std::endl;
+    if (!passed) g_failures++;
+}
+
+// Ripple-carry adder of `bits` full adders built from xor/and/or gates.
+static std::string rippleAdderHDL(int bits) {
+    std::ostringstream in, out, parts, wires;
+    in << "Inputs: cin";
+    out << "Outputs: cout";
+    parts << "Parts: ";
+    wires << "Wires: ";
+    std::string carry = "cin";
+    for (int i = 0; i < bits; ++i) {
+        std::string s = std::to_string(i);
+        in << ", a" << s << ", b" << s;
+        out << ", s" << s;
+        if (i > 0) parts << ", ";
+        parts << "x1_" << s << ":xor, x2_" << s << ":xor, a1_" << s << ":and, a2_" << s << ":and, o_" << s << ":or";
+        if (i > 0) wires << ", ";
+        wires << "a" << s << "->x1_" << s << ".in1, b" << s << "->x1_" << s << ".in2, "
+              << "x1_" << s << ".out->x2_" << s << ".in1, " << carry << "->x2_" << s << ".in2, "
+              << "x2_" << s << ".out->s" << s << ", "
+              << "a" << s << "->a1_" << s << ".in1, b" << s << "->a1_" << s << ".in2, "
+              << "x1_" << s << ".out->a2_" << s << ".in1, " << carry << "->a2_" << s << ".in2, "
+              << "a1_" << s << ".out->o_" << s << ".in1, a2_" << s << ".out->o_" << s << ".in2";
+        carry = "o_" + s + ".out";
+    }
+    wires << ", " << carry << "->cout";
+    return in.str() + ";\n" + out.str() + ";\n" + parts.str() + ";\n" + wires.str() + ";\n";
+}
+
+void test_basic_gates() {
+    Net net = buildNet(parseHDL(
+        "Inputs: a, b;\n"
+        "Outputs: n, x, y;\n"
+        "Parts: g1:nand, g2:xor, g3:nor;\n"
+        "Wires: a->g1.in1, b->g1.in2, g1.out->n, a->g2.in1, b->g2.in2, g2.out->x,"
+        " a->g3.in1, b->g3.in2, g3.out->y;\n"));
+    bool passed = true;
+    for (int m = 0; m < 4; ++m) {
+        int a = m & 1, b = (m >> 1) & 1;
+        auto out = simulate(net, {{"a", a}, {"b", b}});
+        passed &= out["n"] == !(a & b) && out["x"] == (a ^ b) && out["y"] == !(a | b);
+    }
+    printResult("test_basic_gates", passed);
+}
+
+void test_wire_chains_and_undriven_pins() {
+    // g2.in1 is fed from g1's input pin; g3.in2 is left undriven (reads 0).
+    Net net = buildNet(parseHDL(
+        "Inputs: a, b;\n"
+        "Outputs: p, q, r;\n"
+        "Parts: g1:and, g2:not, g3:or;\n"
+        "Wires: a->g1.in1, b->g1.in2, g1.in1->g2.in, g1.out->p, g2.out->q, b->g3.in1, g3.out->r;\n"));
+    bool passed = true;
+    for (int m = 0; m < 4; ++m) {
+        int a = m & 1, b = (m >> 1) & 1;
+        auto out = simulate(net, {{"a", a}, {"b", b}});
+        passed &= out["p"] == (a & b) && out["q"] == !a && out["r"] == b;
+    }
+    printResult("test_wire_chains_and_undriven_pins", passed);
+}
+
+void test_unknown_pins_throw() {
+    bool passed = false;
+    try {
+        buildNet(parseHDL("Inputs: a;\nOutputs: o;\nParts: g:not;\nWires: a->g.bogus, g.out->o;\n"));
+    } catch (const std::runtime_error& e) {
+        passed = std::string(e.what()).find("Unknown dst pin") != std::string::npos;
+    }
+    printResult("test_unknown_pins_throw", passed);
+}
+
+void test_ripple_adder() {
+    const int bits = 4;
+    Net net = buildNet(parseHDL(rippleAdderHDL(bits)));
+    bool passed = true;
+    for (int a = 0; a < (1 << bits); ++a) {
+        for (int b = 0; b < (1 << bits); ++b) {
+            for (int cin = 0; cin < 2; ++cin) {
+                std::unordered_map<std::string, int> in{{"cin", cin}};
+                for (int i = 0; i < bits; ++i) {
+                    in["a" + std::to_string(i)] = (a >> i) & 1;
+                    in["b" + std::to_string(i)] = (b >> i) & 1;
+                }
+                auto out = simulate(net, in);
+                int sum = a + b + cin, got = out["cout"] << bits;
+                for (int i = 0; i < bits; ++i) got |= out["s" + std::to_string(i)] << i;
+                passed &= got == sum;
+            }
+        }
+    }
+    printResult("test_ripple_adder", passed);
+}
+
+void test_deep_chain() {
+    // 201 inverters listed back to front: deeper than the old 64-pass cap.
+    const int depth = 201;
+    std::ostringstream hdl;
+    hdl << "Inputs: a;\nOutputs: o;\nParts: ";
+    for (int i = depth - 1; i >= 0; --i) hdl << "n" << i << ":not" << (i > 0 ? ", " : ";\n");
+    hdl << "Wires: a->n0.in";
+    for (int i = 1; i < depth; ++i) hdl << ", n" << (i - 1) << ".out->n" << i << ".in";
+    hdl << ", n" << (depth - 1) << ".out->o;\n";
+    Net net = buildNet(parseHDL(hdl.str()));
+    bool passed = !net.cyclic && net.loops.empty() && net.gates.size() == depth;
+    passed &= simulate(net, {{"a", 0}})["o"] == 1 && simulate(net, {{"a", 1}})["o"] == 0;
+    printResult("test_deep_chain", passed);
+}
+
+void test_sr_latch() {
+    // Cross-coupled NORs keep their state once s and r return to 0.
+    Net net = buildNet(parseHDL(
+        "Inputs: s, r;\n"
+        "Outputs: q;\n"
+        "Parts: n1:nor, n2:nor;\n"
+        "Wires: r->n1.in1, n2.out->n1.in2, s->n2.in1, n1.out->n2.in2, n1.out->q;\n"));
+    bool passed = net.cyclic;
+    passed &= simulate(net, {{"s", 1}, {"r", 0}})["q"] == 1;
+    passed &= simulate(net, {{"s", 0}, {"r", 0}})["q"] == 1;
+    passed &= simulate(net, {{"s", 0}, {"r", 1}})["q"] == 0;
+    passed &= simulate(net, {{"s", 0}, {"r", 0}})["q"] == 0;
+    printResult("test_sr_latch", passed);
+}
+
+void test_feedback_loops_confined() {
+    // Latch plus logic downstream of it: only the two NORs form a loop
+    Net latch = buildNet(parseHDL(
+        "Inputs: s, r, a;\nOutputs: q, y;\nParts: n1:nor, n2:nor, x:xor, i:not;\n"
+        "Wires: r->n1.in1, n2.out->n1.in2, s->n2.in1, n1.out->n2.in2, n1.out->q,"
+        " n1.out->x.in1, a->x.in2, x.out->i.in, i.out->y;\n"));
+    bool passed = latch.loops.size() == 1 && latch.loops[0].end - latch.loops[0].begin == 2;
+    passed &= latch.level[latch.gates.size() - 1] > latch.level[latch.loops[0].begin];
+    passed &= simulate(latch, {{"s", 1}, {"r", 0}, {"a", 1}})["y"] == 1;
+    passed &= simulate(latch, {{"s", 0}, {"r", 0}, {"a", 0}})["y"] == 0;
+    passed &= oscillatingParts(latch).empty();
+
+    // A NAND feeding itself settles while en=0 and oscillates once en=1
+    const std::string ring =
+        "Inputs: en;\nOutputs: o;\nParts: r:nand;\nWires: en->r.in1, r.out->r.in2, r.out->o;\n";
+    for (SimMode mode : {SimMode::Levelized, SimMode::EventDriven, SimMode::Bytecode}) {
+        Net net = buildNet(parseHDL(ring));
+        net.mode = mode;
+        passed &= net.loops.size() == 1;
+        simulate(net, {{"en", 0}});
+        passed &= oscillatingParts(net).empty();
+        simulate(net, {{"en", 1}});
+        passed &= oscillatingParts(net) == std::vector<std::string>{"r"};
+    }
+    printResult("test_feedback_loops_confined", passed);
+}
+
+void test_event_driven_matches_levelized() {
+    AST ast = parseHDL(rippleAdderHDL(6));
+    Net levelized = buildNet(ast), events = buildNet(ast);
+    events.mode = SimMode::EventDriven;
+    std::vector<uint8_t> in(ast.inputs.size()), want(ast.outputs.size()), got(ast.outputs.size());
+    bool passed = true;
+    uint64_t x = 0x2545F4914F6CDD1Dull;
+    for (int step = 0; step < 500; ++step) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        // Flip one or two inputs per step, as interactive edits do
+        in[x % in.size()] ^= 1;
+        if (x & 0x100) in[(x >> 9) % in.size()] ^= 1;
+        simulate(levelized, in.data(), want.data());
+        simulate(events, in.data(), got.data());
+        passed &= want == got;
+    }
+
+    Net latch = buildNet(parseHDL(
+        "Inputs: s, r;\nOutputs: q;\nParts: n1:nor, n2:nor;\n"
+        "Wires: r->n1.in1, n2.out->n1.in2, s->n2.in1, n1.out->n2.in2, n1.out->q;\n"));
+    latch.mode = SimMode::EventDriven;
+    passed &= simulate(latch, {{"s", 1}, {"r", 0}})["q"] == 1;
+    passed &= simulate(latch, {{"s", 0}, {"r", 0}})["q"] == 1;
+    passed &= simulate(latch, {{"s", 0}, {"r", 1}})["q"] == 0;
+    passed &= simulate(latch, {{"s", 0}, {"r", 0}})["q"] == 0;
+    printResult("test_event_driven_matches_levelized", passed);
+}
+
+void test_input_vectors() {
+    std::vector<uint64_t> rows;
+    for (InputVector v : InputVectors(3)) rows.push_back(v.row);
+    bool passed = rows == std::vector<uint64_t>{0, 1, 2, 3, 4, 5, 6, 7};
+
+    // Windows, unpacking and widths past the old 31-input limit
+    InputVectors window(40, (1ull << 39) - 1, 2);
+    std::vector<uint8_t> in(40);
+    auto it = window.begin();
+    (*it).unpack(in.data(), in.size());
+    passed &= window.size() == 2 && in[0] == 1 && in[38] == 1 && in[39] == 0;
+    ++it;
+    passed &= (*it)[39] == 1 && (*it)[0] == 0 && ++it == window.end();
+    passed &= InputVectors(0).size() == 1 && InputVectors(63).size() == 1ull << 63;
+
+    int threw = 0;
+    for (auto make : {+[] { InputVectors(64); }, +[] { InputVectors(4, 10, 7); }}) {
+        try {
+            make();
+        } catch (const std::runtime_error&) {
+            threw++;
+        }
+    }
+    printResult("test_input_vectors", passed && threw == 2);
+}
+
+void test_bit_parallel_truth_table() {
+    // 9 inputs -> 512 rows, several 64-lane words; compare with scalar simulate.
+    const int bits = 4;
+    AST ast = parseHDL(rippleAdderHDL(bits));
+    Net bitNet = buildNet(ast), scalarNet = buildNet(ast);
+    bool passed = BitSim::supports(bitNet);
+    uint64_t rows = 0;
+    std::vector<uint8_t> in(ast.inputs.size()), out(ast.outputs.size());
+    enumerateTruthTable(bitNet, [&](const TruthBlock& block) {
+        for (uint64_t r = block.base; r < block.base + block.count; ++r, ++rows) {
+            for (size_t i = 0; i < in.size(); ++i) in[i] = (r >> i) & 1;
+            simulate(scalarNet, in.data(), out.data());
+            for (size_t o = 0; o < out.size(); ++o) passed &= block.out(o, r) == out[o];
+        }
+    }, 2);
+    passed &= rows == (1u << ast.inputs.size());
+    printResult("test_bit_parallel_truth_table", passed);
+}
+
+void test_parallel_enumeration_order() {
+    // Small blocks and several workers; output must match the serial walk.
+    Net net = buildNet(parseHDL(rippleAdderHDL(4)));
+    auto format = [](const TruthBlock& block, std::string& text) {
+        for (uint64_t r = block.base; r < block.base + block.count; ++r) {
+            text += std::to_string(r) + ":" + std::to_string(block.out(0, r)) + std::to_string(block.out(1, r)) + "\n";
+        }
+    };
+    std::string serial, parallel;
+    enumerateTruthTableParallel(net, 1, format, [&](const std::string& t) { serial += t; }, 1);
+    enumerateTruthTableParallel(net, 3, format, [&](const std::string& t) { parallel += t; }, 1);
+    printResult("test_parallel_enumeration_order", !serial.empty() && serial == parallel);
+}
+
+void test_gate_kernels_agree() {
+    // Every kernel set available on this CPU must match the scalar one,
+    // including the non-multiple-of-vector-width tail.
+    const size_t n = 37;
+    std::vector<uint64_t> a(n), b(n), want(n), got(n);
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < n; ++i) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17; a[i] = x;
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17; b[i] = x;
+    }
+    const GateKernels& ref = *gateKernelsByName("scalar");
+    bool passed = true;
+    std::string tried;
+    for (const char* name : {"scalar", "avx2", "avx512"}) {
+        const GateKernels* k = gateKernelsByName(name);
+        if (!k) continue;
+        tried += std::string(tried.empty() ? "" : ",") + name;
+        auto check = [&](auto refOp, auto op) {
+            refOp(want.data(), a.data(), b.data(), n);
+            op(got.data(), a.data(), b.data(), n);
+            passed &= want == got;
+        };
+        check(ref.andOp, k->andOp);
+        check(ref.orOp, k->orOp);
+        check(ref.xorOp, k->xorOp);
+        check(ref.nandOp, k->nandOp);
+        check(ref.norOp, k->norOp);
+        ref.notOp(want.data(), a.data(), n);
+        k->notOp(got.data(), a.data(), n);
+        passed &= want == got;
+
+        // Counting: with and without a mask (b masks a ^ ~a, i.e. counts b)
+        passed &= k->popcount(a.data(), n) == ref.popcount(a.data(), n);
+        std::fill(want.begin(), want.end(), 1);
+        std::fill(got.begin(), got.end(), 1);
+        passed &= k->diffCount(got.data(), a.data(), b.data(), nullptr, n) ==
+                  ref.diffCount(want.data(), a.data(), b.data(), nullptr, n) && want == got;
+        std::vector<uint64_t> na(n);
+        for (size_t i = 0; i < n; ++i) na[i] = ~a[i];
+        passed &= k->diffCount(got.data(), a.data(), na.data(), b.data(), n) == ref.popcount(b.data(), n);
+    }
+    printResult("test_gate_kernels_agree", passed, tried + " (active: " + gateKernels().name + ")");
+}
+
+// Random acyclic netlist over `nin` inputs; gates read earlier signals,
+// some pins are left undriven (constant 0) and some gates feed nothing.
+static std::string randomHDL(int nin, int ngates, uint64_t seed) {
+    static const char* kinds[] = {"not", "and", "or", "xor", "nand", "nor"};
+    auto next = [&]() { seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; return seed; };
+    std::vector<std::string> sigs;
+    std::ostringstream in, parts, wires;
+    in << "Inputs: ";
+    for (int i = 0; i < nin; ++i) {
+        in << (i ? ", " : "") << "i" << i;
+        sigs.push_back("i" + std::to_string(i));
+    }
+    parts << "Parts: ";
+    wires << "Wires: ";
+    bool firstWire = true;
+    for (int g = 0; g < ngates; ++g) {
+        std::string kind = kinds[next() % 6], name = "g" + std::to_string(g);
+        parts << (g ? ", " : "") << name << ":" << kind;
+        std::vector<std::string> pinsOf = kind == std::string("not") ? std::vector<std::string>{"in"}
+                                                                      : std::vector<std::string>{"in1", "in2"};
+        std::string prev;
+        for (auto& pin : pinsOf) {
+            if (next() % 16 == 0) continue;  // undriven
+            // Reuse the previous operand now and then (x&x, nand(x,x), ...)
+            std::string src = (!prev.empty() && next() % 4 == 0) ? prev : sigs[next() % sigs.size()];
+            wires << (firstWire ? "" : ", ") << src << "->" << name << "." << pin;
+            firstWire = false;
+            prev = src;
+        }
+        sigs.push_back(name + ".out");
+    }
+    std::ostringstream out;
+    out << "Outputs: ";
+    for (int o = 0; o < 3; ++o) {
+        out << (o ? ", " : "") << "o" << o;
+        wires << ", " << sigs[sigs.size() - 1 - o * 3] << "->o" << o;
+    }
+    return in.str() + ";\n" + out.str() + ";\n" + parts.str() + ";\n" + wires.str() + ";\n";
+}
+
+void test_incremental_cones() {
+    // Blocks visited out of order: each incremental runCombos must match a
+    // full evaluation of the same block.
+    bool passed = true;
+    for (uint64_t seed = 1; seed <= 5; ++seed) {
+        Net net = buildNet(parseHDL(randomHDL(12, 120, seed * 0x9E3779B97F4A7C15ull)));
+        BitSim inc(net, 2), full(net, 2);
+        uint64_t blocks = (1ull << 12) / 128, x = seed;
+        for (int step = 0; step < 200; ++step) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            uint64_t base = (x % blocks) * 128;
+            inc.runCombos(base);
+            full.loadCombos(base);
+            full.run();
+            for (size_t o = 0; o < net.outputIds.size(); ++o) {
+                passed &= std::equal(inc.output(o), inc.output(o) + 2, full.output(o));
+            }
+        }
+    }
+    printResult("test_incremental_cones", passed);
+}
+
+void test_optimizer_preserves_function() {
+    bool passed = true;
+    size_t removed = 0;
+    for (uint64_t seed = 1; seed <= 20; ++seed) {
+        AST ast = parseHDL(randomHDL(6, 60, seed * 0x9E3779B97F4A7C15ull));
+        Net ref = buildNet(ast), opt = buildNet(ast);
+        OptimizeStats st = optimizeNet(opt);
+        removed += st.removed();
+        passed &= st.gatesAfter == opt.gates.size() && st.removed() == st.folded + st.merged + st.dead;
+        std::vector<uint8_t> in(ast.inputs.size()), want(ast.outputs.size()), got(ast.outputs.size());
+        for (uint64_t r = 0; r < (1u << ast.inputs.size()); ++r) {
+            for (size_t i = 0; i < in.size(); ++i) in[i] = (r >> i) & 1;
+            simulate(ref, in.data(), want.data());
+            simulate(opt, in.data(), got.data());
+            passed &= want == got;
+        }
+    }
+
+    // NAND(x,x) inverters twice over collapse back to a wire
+    Net inv = buildNet(parseHDL(
+        "Inputs: a;\nOutputs: o;\nParts: n1:nand, n2:nand, d:and;\n"
+        "Wires: a->n1.in1, a->n1.in2, n1.out->n2.in1, n1.out->n2.in2, a->d.in1, n2.out->o;\n"));
+    OptimizeStats st = optimizeNet(inv);
+    passed &= inv.gates.empty() && st.removed() == 3 && inv.outputIds[0] == inv.inputIds[0];
+    printResult("test_optimizer_preserves_function", passed && removed > 0,
+                std::to_string(removed) + " gates removed across random nets");
+}
+
+// Writes a small component library (NAND-only, as the designer requires) to a temp dir.
+static std::string writeComponentLibrary() {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "minlab_test_components";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::ofstream(dir / "inv.hdl") <<
+        "# Name: inv\n"
+        "Inputs: in;\nOutputs: out;\nParts: n:nand;\nWires: in->n.in1, in->n.in2, n.out->out;\n";
+    std::ofstream(dir / "xor2.hdl") <<
+        "# Name: xor2\n"
+        "Inputs: a, b;\nOutputs: out;\nParts: n1:nand, n2:nand, n3:nand, n4:nand;\n"
+        "Wires: a->n1.in1, b->n1.in2, a->n2.in1, n1.out->n2.in2, n1.out->n3.in1, b->n3.in2,"
+        " n2.out->n4.in1, n3.out->n4.in2, n4.out->out;\n";
+    // Nested: or2 = nand(inv(a), inv(b)); fa = full adder from xor2/or2 and nands
+    std::ofstream(dir / "or2.hdl") <<
+        "# Name: or2\n"
+        "Inputs: a, b;\nOutputs: out;\nParts: i1:inv, i2:inv, n:nand;\n"
+        "Wires: a->i1.in, b->i2.in, i1.out->n.in1, i2.out->n.in2, n.out->out;\n";
+    std::ofstream(dir / "fa.hdl") <<
+        "# Name: fa\n"
+        "Inputs: a, b, c;\nOutputs: s, co;\nParts: x1:xor2, x2:xor2, n1:nand, n2:nand, i1:inv, i2:inv, o:or2;\n"
+        "Wires: a->x1.a, b->x1.b, x1.out->x2.a, c->x2.b, x2.out->s,"
+        " a->n1.in1, b->n1.in2, n1.out->i1.in, x1.out->n2.in1, c->n2.in2, n2.out->i2.in,"
+        " i1.out->o.a, i2.out->o.b, o.out->co;\n";
+    // Seven inputs: wide enough for the multi-word lookup path in BitSim
+    std::ofstream(dir / "par7.hdl") <<
+        "# Name: par7\n"
+        "Inputs: a, b, c, d, e, f, g;\nOutputs: p;\nParts: x1:xor2, x2:xor2, x3:xor2, x4:xor2, x5:xor2, x6:xor2;\n"
+        "Wires: a->x1.a, b->x1.b, x1.out->x2.a, c->x2.b, x2.out->x3.a, d->x3.b, x3.out->x4.a, e->x4.b,"
+        " x4.out->x5.a, f->x5.b, x5.out->x6.a, g->x6.b, x6.out->p;\n";
+    // No outputs at all, so an unflattened instance has no signal of its own
+    std::ofstream(dir / "sink.hdl") <<
+        "# Name: sink\n"
+        "Inputs: a;\nOutputs: ;\nParts: n:nand;\nWires: a->n.in1, a->n.in2;\n";
+    return dir.string();
+}
+
+// par7 feeding fa from writeComponentLibrary(): one lookup table of each
+// width once the components are tabulated.
+static std::string lutCircuitHDL() {
+    return "Inputs: a, b, c, d, e, f, g, h;\n"
+           "Outputs: p, s, co;\n"
+           "Parts: u:par7, v:fa;\n"
+           "Wires: a->u.a, b->u.b, c->u.c, d->u.d, e->u.e, f->u.f, g->u.g, u.p->p,"
+           " a->v.a, h->v.b, u.p->v.c, v.s->s, v.co->co;\n";
+}
+
+// lutCircuitHDL() built with its components as lookup tables and kept as
+// unflattened sub-instances.
+static std::pair<Net, Net> lutAndHierNets(ComponentLibrary& lib) {
+    AST ast = parseHDL(lutCircuitHDL());
+    BuildOptions keep;
+    keep.flatten = false;
+    return {buildNetWithComponents(ast, &lib), buildNetWithComponents(ast, &lib, keep)};
+}
+
+void test_custom_components() {
+    ComponentLibrary lib;
+    lib.loadComponents(writeComponentLibrary());
+    Net net = buildNetWithComponents(parseHDL(
+        "Inputs: a, b;\n"
+        "Outputs: x, nx;\n"
+        "Parts: u1:xor2, u2:inv;\n"
+        "Wires: a->u1.a, b->u1.b, u1.out->x, u1.out->u2.in, u2.out->nx;\n"), &lib);
+    bool passed = true;
+    for (int m = 0; m < 4; ++m) {
+        int a = m & 1, b = (m >> 1) & 1;
+        auto out = simulate(net, {{"a", a}, {"b", b}});
+        passed &= out["x"] == (a ^ b) && out["nx"] == !(a ^ b);
+    }
+    printResult("test_custom_components", passed);
+}
+
+void test_nested_components_flattened() {
+    ComponentLibrary lib;
+    lib.loadComponents(writeComponentLibrary());
+    AST ast = parseHDL(
+        "Inputs: a0, a1, b0, b1;\n"
+        "Outputs: s0, s1, c;\n"
+        "Parts: f0:fa, f1:fa;\n"
+        "Wires: a0->f0.a, b0->f0.b, f0.s->s0, f0.co->f1.c, a1->f1.a, b1->f1.b, f1.s->s1, f1.co->c;\n");
+    BuildOptions keep;
+    keep.flatten = false;
+    Net flat = buildNetWithComponents(ast, &lib);
+    Net hier = buildNetWithComponents(ast, &lib, keep);
+    bool passed = lib.hasComponent("fa") && flat.subs.empty() && hier.subs.size() == 2;
+    for (int m = 0; m < 16; ++m) {
+        int a = m & 3, b = m >> 2;
+        std::unordered_map<std::string, int> in{{"a0", a & 1}, {"a1", a >> 1}, {"b0", b & 1}, {"b1", b >> 1}};
+        auto f = simulate(flat, in), h = simulate(hier, in);
+        passed &= (f["s0"] | f["s1"] << 1 | f["c"] << 2) == a + b && f == h;
+    }
+    Net sink = buildNetWithComponents(parseHDL("Inputs: a;\nOutputs: o;\nParts: u:sink;\nWires: a->u.a, a->o;\n"),
+                                      &lib, keep);
+    passed &= sink.subs.size() == 1 && simulate(sink, {{"a", 1}})["o"] == 1 && oscillatingParts(sink).empty();
+    printResult("test_nested_components_flattened", passed);
+}
+
+void test_component_lookup_tables() {
+    ComponentLibrary lib;
+    lib.loadComponents(writeComponentLibrary());
+    AST ast = parseHDL(lutCircuitHDL());
+    BuildOptions gatesOnly;
+    gatesOnly.useLuts = false;
+    Net lut = buildNetWithComponents(ast, &lib);
+    Net gates = buildNetWithComponents(ast, &lib, gatesOnly);
+    bool passed = lib.getComponent("par7")->lut && lut.luts.size() == 3 && gates.luts.empty();
+
+    // Bit-parallel LUT evaluation (both the <=6 and the >6 input path)
+    // against scalar lookups and against the plain gate netlist.
+    std::vector<uint8_t> in(ast.inputs.size()), want(ast.outputs.size()), got(ast.outputs.size());
+    enumerateTruthTable(lut, [&](const TruthBlock& block) {
+        for (uint64_t r = block.base; r < block.base + block.count; ++r) {
+            for (size_t i = 0; i < in.size(); ++i) in[i] = (r >> i) & 1;
+            simulate(gates, in.data(), want.data());
+            simulate(lut, in.data(), got.data());
+            for (size_t o = 0; o < want.size(); ++o) passed &= block.out(o, r) == want[o] && got[o] == want[o];
+        }
+    });
+
+    lib.setLutMaxInputs(0);
+    lib.loadComponents(writeComponentLibrary());
+    passed &= !lib.getComponent("fa")->lut && buildNetWithComponents(ast, &lib).luts.empty();
+    printResult("test_component_lookup_tables", passed);
+}
+
+// Average microseconds per simulate() call over all rows of net.
+static double timeRows(Net& net, int repeats) {
+    std::vector<uint8_t> in(net.inputIds.size()), out(net.outputIds.size());
+    uint64_t rows = 1ull << in.size();
+    auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < repeats; ++k) {
+        for (uint64_t r = 0; r < rows; ++r) {
+            for (size_t i = 0; i < in.size(); ++i) in[i] = (r >> i) & 1;
+            simulate(net, in.data(), out.data());
+        }
+    }
+    std::chrono::duration<double, std::micro> took = std::chrono::steady_clock::now() - start;
+    return took.count() / (repeats * rows);
+}
+
+void test_bytecode_matches_levelized() {
+    bool passed = true;
+    auto agree = [&](Net& ref, Net& vm) {
+        vm.mode = SimMode::Bytecode;
+        std::vector<uint8_t> in(ref.inputIds.size()), want(ref.outputIds.size()), got(ref.outputIds.size());
+        for (uint64_t r = 0; r < (1ull << in.size()); ++r) {
+            for (size_t i = 0; i < in.size(); ++i) in[i] = (r >> i) & 1;
+            simulate(ref, in.data(), want.data());
+            simulate(vm, in.data(), got.data());
+            passed &= want == got;
+        }
+    };
+    for (uint64_t seed = 1; seed <= 10; ++seed) {
+        AST ast = parseHDL(randomHDL(7, 60, seed * 0x9E3779B97F4A7C15ull));
+        Net ref = buildNet(ast), vm = buildNet(ast);
+        agree(ref, vm);
+    }
+
+    // Sub-instances and lookup tables
+    ComponentLibrary lib;
+    lib.loadComponents(writeComponentLibrary());
+    auto ref = lutAndHierNets(lib), vm = lutAndHierNets(lib);
+    agree(ref.first, vm.first);
+    agree(ref.second, vm.second);
+
+    // The loop section keeps latch state between calls
+    Net latch = buildNet(parseHDL(
+        "Inputs: s, r;\nOutputs: q;\nParts: n1:nor, n2:nor;\n"
+        "Wires: r->n1.in1, n2.out->n1.in2, s->n2.in1, n1.out->n2.in2, n1.out->q;\n"));
+    latch.mode = SimMode::Bytecode;
+    passed &= simulate(latch, {{"s", 1}, {"r", 0}})["q"] == 1;
+    passed &= simulate(latch, {{"s", 0}, {"r", 0}})["q"] == 1;
+    passed &= simulate(latch, {{"s", 0}, {"r", 1}})["q"] == 0;
+    passed &= simulate(latch, {{"s", 0}, {"r", 0}})["q"] == 0;
+
+    // Rough comparison on a larger net, reported rather than asserted
+    AST big = parseHDL(randomHDL(10, 300, 42));
+    Net levelized = buildNet(big), bytecode = buildNet(big);
+    bytecode.mode = SimMode::Bytecode;
+    std::ostringstream details;
+    details.precision(2);
+    details << std::fixed << "300 gates: bytecode " << timeRows(bytecode, 10) << " us/vector, levelized "
+            << timeRows(levelized, 10) << " us/vector";
+    printResult("test_bytecode_matches_levelized", passed, details.str());
+}
+
+// Collects every output bit of an exhaustive enumeration on one engine.
+static std::vector<int> truthTableOn(Net& net, SimEngine engine) {
+    std::vector<int> bits;
+    enumerateTruthTable(net, [&](const TruthBlock& block) {
+        for (uint64_t r = block.base; r < block.base + block.count; ++r) {
+            for (size_t o = 0; o < net.outputIds.size(); ++o) bits.push_back(block.out(o, r));
+        }
+    }, 2, engine);
+    return bits;
+}
+
+void test_aig_engine() {
+    bool passed = true;
+    for (uint64_t seed = 1; seed <= 10; ++seed) {
+        Net net = buildNet(parseHDL(randomHDL(9, 80, seed * 0x9E3779B97F4A7C15ull)));
+        passed &= truthTableOn(net, SimEngine::Aig) == truthTableOn(net, SimEngine::Netlist);
+    }
+
+    // Lookup tables (both widths) and unflattened sub-instances lower too
+    ComponentLibrary lib;
+    lib.loadComponents(writeComponentLibrary());
+    auto [lut, hier] = lutAndHierNets(lib);
+    std::vector<int> want = truthTableOn(lut, SimEngine::Netlist);
+    passed &= truthTableOn(lut, SimEngine::Aig) == want && truthTableOn(hier, SimEngine::Aig) == want;
+
+    // Structural hashing: x ^ x built from shared NANDs folds away entirely
+    Aig adder = buildAig(buildNet(parseHDL(rippleAdderHDL(8))));
+    Aig same = buildAig(buildNet(parseHDL(
+        "Inputs: a;\nOutputs: o;\nParts: x:xor;\nWires: a->x.in1, a->x.in2, x.out->o;\n")));
+    passed &= same.numAnds() == 0 && same.outputs[0] == Aig::kFalse && adder.depth() > 8;
+
+    bool threw = false;
+    try {
+        buildAig(buildNet(parseHDL(
+            "Inputs: s, r;\nOutputs: q;\nParts: n1:nor, n2:nor;\n"
+            "Wires: r->n1.in1, n2.out->n1.in2, s->n2.in1, n1.out->n2.in2, n1.out->q;\n")));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    printResult("test_aig_engine", passed && threw,
+                std::to_string(adder.numAnds()) + " ANDs for an 8-bit ripple adder");
+}
+
+void test_native_engine() {
+    namespace fs = std::filesystem;
+    fs::path cache = fs::temp_directory_path() / "minlab_test_cache";
+    fs::remove_all(cache);
+    setenv("MINLAB_CACHE", cache.c_str(), 1);
+
+    bool passed = true;
+    for (uint64_t seed = 1; seed <= 3; ++seed) {
+        Net net = buildNet(parseHDL(randomHDL(9, 80, seed * 0x9E3779B97F4A7C15ull)));
+        passed &= truthTableOn(net, SimEngine::Native) == truthTableOn(net, SimEngine::Netlist);
+    }
+
+    // Both lookup-table shapes and an unflattened instance in one library
+    ComponentLibrary lib;
+    lib.loadComponents(writeComponentLibrary());
+    auto [lut, hier] = lutAndHierNets(lib);
+    std::vector<int> want = truthTableOn(lut, SimEngine::Netlist);
+    passed &= truthTableOn(lut, SimEngine::Native) == want && truthTableOn(hier, SimEngine::Native) == want;
+
+    // Same netlist, same artifact
+    size_t cached = std::distance(fs::directory_iterator(cache), fs::directory_iterator());
+    passed &= compileNative(lut) == compileNative(lut) &&
+              std::distance(fs::directory_iterator(cache), fs::directory_iterator()) == static_cast<long>(cached);
+    fs::remove_all(cache);
+    printResult("test_native_engine", passed, std::to_string(cached) + " libraries compiled");
+}
+
+// Writes ast's table with the binary writer, as `minlab --format=bin` does.
+static void writeTable(const AST& ast, Net& net, const std::string& path, unsigned threads) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    TruthFileWriter writer(fd, ast.inputs, ast.outputs);
+    enumerateTruthTableParallel(net, threads, TruthFileWriter::pack,
+        [&](const std::string& buf) { writer.append(buf); }, 4);
+    writer.finish();
+    close(fd);
+}
+
+void test_truth_file() {
+    namespace fs = std::filesystem;
+    std::string a = (fs::temp_directory_path() / "minlab_test_a.bin").string();
+    std::string b = (fs::temp_directory_path() / "minlab_test_b.bin").string();
+    bool passed = true;
+
+    // Several blocks across threads, and a table shorter than one word
+    for (int nin : {11, 3}) {
+        AST ast = parseHDL(randomHDL(nin, 60, 0x5EED + nin));
+        Net net = buildNet(ast);
+        writeTable(ast, net, a, 3);
+        TruthFile t(a);
+        std::vector<int> want = truthTableOn(net, SimEngine::Netlist), got;
+        for (uint64_t r = 0; r < t.rows(); ++r) {
+            for (size_t o = 0; o < t.outputs().size(); ++o) got.push_back(t.bit(o, r));
+        }
+        passed &= t.inputs() == ast.inputs && t.outputs() == ast.outputs && got == want;
+        if (nin == 3) passed &= (t.column(0)[0] >> 8) == 0;
+    }
+
+    // Rewiring cout changes only that column; the diff agrees with a bit-by-bit scan
+    AST ast = parseHDL(rippleAdderHDL(4));
+    Net net = buildNet(ast);
+    writeTable(ast, net, a, 1);
+    AST broken = ast;
+    broken.wires.back().src = "a0";
+    Net other = buildNet(broken);
+    writeTable(broken, other, b, 2);
+    TruthFile ta(a), tb(b);
+    uint64_t diffs = 0;
+    for (size_t o = 0; o < ta.outputs().size(); ++o) {
+        uint64_t first = ~0ull, wantFirst = ~0ull, want = 0;
+        uint64_t n = countDifferences(ta.column(o), tb.column(o), ta.columnWords(), first);
+        for (uint64_t r = 0; r < ta.rows(); ++r) {
+            if (ta.bit(o, r) == tb.bit(o, r)) continue;
+            if (!want++) wantFirst = r;
+        }
+        passed &= n == want && first == wantFirst && (n == 0 || ta.outputs()[o] == "cout");
+        diffs += n;
+    }
+    passed &= diffs > 0;
+    fs::remove(a);
+    fs::remove(b);
+    printResult("test_truth_file", passed, std::to_string(diffs) + " differing bits");
+}
+
+void test_row_formats() {
+    AST ast = parseHDL("Inputs: a, b;\nOutputs: x, y;\nParts: g:xor, h:and;\n"
+                       "Wires: a->g.in1, b->g.in2, a->h.in1, b->h.in2, g.out->x, h.out->y;\n");
+    Net net = buildNet(ast);
+    auto render = [&](TableFormat format, unsigned threads) {
+        RowFormatter formatter(format, ast.inputs, ast.outputs);
+        std::string all = formatter.header();
+        enumerateTruthTableParallel(net, threads,
+            [&](const TruthBlock& block, std::string& text) { formatter.format(block, text); },
+            [&](const std::string& text) { all += text; });
+        return all + formatter.footer();
+    };
+    std::string text = render(TableFormat::Text, 1);
+    std::string csv = render(TableFormat::Csv, 2);
+    std::string pla = render(TableFormat::Pla, 1);
+    bool passed = text == "in {a:0,b:0} -> out {x:0,y:0}\nin {a:1,b:0} -> out {x:1,y:0}\n"
+                          "in {a:0,b:1} -> out {x:1,y:0}\nin {a:1,b:1} -> out {x:0,y:1}\n" &&
+                  csv == "a,b,x,y\n0,0,0,0\n1,0,1,0\n0,1,1,0\n1,1,0,1\n" &&
+                  pla == ".i 2\n.o 2\n.ilb a b\n.ob x y\n.type fr\n.p 4\n00 00\n10 10\n01 10\n11 01\n.e\n";
+
+    // Many blocks formatted on several workers come out in row order
+    AST big = parseHDL(randomHDL(14, 60, 0xF00D));
+    Net bigNet = buildNet(big);
+    RowFormatter formatter(TableFormat::Csv, big.inputs, big.outputs);
+    std::string serial, parallel;
+    enumerateTruthTableParallel(bigNet, 1,
+        [&](const TruthBlock& block, std::string& t) { formatter.format(block, t); },
+        [&](const std::string& t) { serial += t; }, 2);
+    enumerateTruthTableParallel(bigNet, 4,
+        [&](const TruthBlock& block, std::string& t) { formatter.format(block, t); },
+        [&](const std::string& t) { parallel += t; }, 2);
+    passed &= serial == parallel && std::count(serial.begin(), serial.end(), '\n') == (1 << 14);
+    printResult("test_row_formats", passed);
+}
+
+// A level whose expected table is hdl's full truth table. lastOut, if not
+// empty, replaces the outputs of the final case.
+static Level levelFromHDL(const std::string& hdl, const ExpectedTable::Values* lastOut = nullptr) {
+    AST ast = parseHDL(hdl);
+    Net net = buildNet(ast);
+    Level level;
+    level.id = "generated";
+    level.available_gates = {"not", "and", "or", "xor", "nand", "nor"};
+    level.inputs = ast.inputs;
+    level.outputs = ast.outputs;
+    level.expected = ExpectedTable(ast.inputs, ast.outputs);
+    InputVectors vectors(ast.inputs.size());
+    for (InputVector v : vectors) {
+        std::unordered_map<std::string, int> in;
+        ExpectedTable::Values inVals, outVals;
+        for (size_t i = 0; i < ast.inputs.size(); ++i) {
+            in[ast.inputs[i]] = v[i];
+            inVals.emplace_back(ast.inputs[i], v[i]);
+        }
+        for (const auto& kv : simulate(net, in)) outVals.emplace_back(kv.first, kv.second);
+        level.expected.addCase(inVals, lastOut && v.row + 1 == vectors.size() ? *lastOut : outVals);
+    }
+    return level;
+}
+
+void test_validate_solution() {
+    Game game;
+    const std::string hdl = randomHDL(13, 120, 0xC0FFEE);
+    Level level = levelFromHDL(hdl);
+    bool passed = game.validateSolution(level, hdl) && level.expected.cases == 1u << 13;
+
+    // A single wrong case in the last chunk is still found, and a
+    // don't-care there is not held against the solution
+    const ExpectedTable& t = level.expected;
+    size_t last = t.cases - 1;
+    ExpectedTable::Values flipped;
+    for (size_t o = 0; o < t.outputs.size(); ++o) flipped.emplace_back(t.outputs[o], t.outputBit(o, last) ^ (o == 0));
+    Level wrong = levelFromHDL(hdl, &flipped);
+    passed &= !game.validateSolution(wrong, hdl);
+    AST ast = parseHDL(hdl);
+    Net net = buildNet(ast);
+    MismatchTally tally = checkTable(net, ast.inputs, ast.outputs, wrong.expected, SimEngine::Netlist, 4);
+    passed &= tally.failedCases == 1 && tally.perOutput[0] == 1 && tally.failures.size() == 1 &&
+              tally.failures[0].c == last && tally.failures[0].got[0] == t.outputBit(0, last);
+    for (size_t o = 1; o < t.outputs.size(); ++o) passed &= tally.perOutput[o] == 0;
+    flipped.erase(flipped.begin());
+    Level dontCare = levelFromHDL(hdl, &flipped);
+    passed &= game.validateSolution(dontCare, hdl) && !dontCare.expected.cares(0, last);
+    game.setSimEngine(SimEngine::Aig);
+    passed &= game.validateSolution(dontCare, hdl);
+
+    // Latches replay the cases in order
+    const std::string latch =
+        "Inputs: s, r;\nOutputs: q;\nParts: n1:nor, n2:nor;\n"
+        "Wires: r->n1.in1, n2.out->n1.in2, s->n2.in1, n1.out->n2.in2, n1.out->q;\n";
+    Level hold;
+    hold.available_gates = {"nor", "or"};
+    hold.inputs = {"s", "r"};
+    hold.outputs = {"q"};
+    hold.expected = ExpectedTable(hold.inputs, hold.outputs);
+    for (auto [s, r, q] : {std::array<int, 3>{1, 0, 1}, {0, 0, 1}, {0, 1, 0}, {0, 0, 0}}) {
+        hold.expected.addCase({{"s", s}, {"r", r}}, {{"q", q}});
+    }
+    passed &= game.validateSolution(hold, latch);
+    AST latchAst = parseHDL(latch);
+    Net latchNet = buildNet(latchAst);
+    latchNet.mode = SimMode::Bytecode;
+    passed &= checkTable(latchNet, latchAst.inputs, latchAst.outputs, hold.expected, SimEngine::Netlist, 1)
+                      .failedCases == 0 &&
+              latchNet.mode == SimMode::Bytecode;
+    passed &= !game.validateSolution(hold, "Inputs: s, r;\nOutputs: q;\nParts: g:or;\n"
+                                           "Wires: s->g.in1, s->g.in2, g.out->q;\n");
+    printResult("test_validate_solution", passed);
+}
+
+// Writes dir/<id>.json: a level over the given ports with every gate
+// available, whose expected outputs come from `fields` (JSON members).
+static void writeLevelJson(const std::filesystem::path& dir, const std::string& id,
+                           const std::vector<std::string>& inputs, const std::vector<std::string>& outputs,
+                           const std::string& fields) {
+    auto list = [](const std::vector<std::string>& names) {
+        std::string s;
+        for (const auto& n : names) s += (s.empty() ? "\"" : ", \"") + n + "\"";
+        return "[" + s + "]";
+    };
+    std::ofstream(dir / (id + ".json")) << "{\"id\": \"" << id << "\", \"name\": \"" << id << "\", \"difficulty\": 1,\n"
+                                        << " \"available_gates\": [\"not\", \"and\", \"or\", \"xor\", \"nand\", \"nor\"],\n"
+                                        << " \"inputs\": " << list(inputs) << ", \"outputs\": " << list(outputs) << ",\n "
+                                        << fields << "}\n";
+}
+
+void test_compact_levels() {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "minlab_test_levels";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    // Inline hex: out = a OR b, except that a=b=1 is a don't-care
+    writeLevelJson(dir, "hex", {"a", "b"}, {"out"}, "\"truth_table\": {\"out\": \"e\"}, \"dont_care\": {\"out\": \"8\"}");
+    writeLevelJson(dir, "badhex", {"a"}, {"out"}, "\"truth_table\": {\"out\": \"7\"}");
+
+    // Sidecar written the way `minlab --format=bin` writes it
+    const std::string hdl = randomHDL(20, 200, 0xB16);
+    AST ast = parseHDL(hdl);
+    Net net = buildNet(ast);
+    writeTable(ast, net, (dir / "big.mlt").string(), 2);
+    writeLevelJson(dir, "big", ast.inputs, ast.outputs, "\"truth_table_file\": \"big.mlt\"");
+
+    Game game;
+    bool passed = game.loadLevels(dir.string()) && game.getLevels().size() == 2 && !game.getLevel("badhex");
+    const Level* hex = game.getLevel("hex");
+    const Level* big = game.getLevel("big");
+    passed &= hex && big && hex->expected.exhaustive && big->expected.cases == 1u << 20;
+    if (passed) {
+        auto gate = [](const std::string& kind) {
+            return "Inputs: a, b;\nOutputs: out;\nParts: g:" + kind + ";\nWires: a->g.in1, b->g.in2, g.out->out;\n";
+        };
+        passed &= game.validateSolution(*hex, gate("or")) && game.validateSolution(*hex, gate("xor")) &&
+                  !game.validateSolution(*hex, gate("nand"));
+        passed &= game.validateSolution(*big, hdl) && !game.validateSolution(*big, randomHDL(20, 200, 0xB17));
+    }
+    fs::remove_all(dir);
+    printResult("test_compact_levels", passed);
+}
+
+// 16 inputs; output p<k> is the AND (OR for orPair) of inputs 2k and
+// 2k+1, x reads i3 and i12, y is wired to i9 and z is undriven.
+static std::string pairsHDL(size_t orPair = SIZE_MAX, bool reversedInputs = false) {
+    std::ostringstream in, parts, wires;
+    for (int i = 0; i < 16; ++i) {
+        in << (i ? ", " : "") << "i" << (reversedInputs ? 15 - i : i);
+    }
+    for (size_t k = 0; k < 8; ++k) {
+        parts << "g" << k << (k == orPair ? ":or, " : ":and, ");
+        wires << "i" << 2 * k << "->g" << k << ".in1, i" << 2 * k + 1 << "->g" << k << ".in2, g" << k << ".out->p" << k
+              << ", ";
+    }
+    return "Inputs: " + in.str() + ";\nOutputs: p0, p1, p2, p3, p4, p5, p6, p7, x, y, z;\nParts: " + parts.str() +
+           "h:xor;\nWires: " + wires.str() + "i3->h.in1, i12->h.in2, h.out->x, i9->y;\n";
+}
+
+void test_output_support() {
+    AST ast = parseHDL(pairsHDL());
+    Net net = buildNet(ast), scalar = buildNet(ast);
+    bool passed = net.outputSupport.size() == 11 && net.outputSupport[3] == std::vector<uint32_t>{6, 7} &&
+                  net.outputSupport[8] == std::vector<uint32_t>{3, 12} &&
+                  net.outputSupport[9] == std::vector<uint32_t>{9} && net.outputSupport[10].empty();
+    Net adder = buildNet(parseHDL(rippleAdderHDL(4)));
+    passed &= adder.outputSupport[0].size() == 9 && adder.outputSupport[1].size() == 3;  // cout, s0
+
+    // Few enough rows that cone tables replace the 2^16-row enumeration
+    passed &= coneRows(net) < (1u << 16);
+    std::vector<uint8_t> in(16), out(ast.outputs.size());
+    uint64_t rows = 0;
+    enumerateTruthTable(net, [&](const TruthBlock& block) {
+        for (uint64_t r = block.base; r < block.base + block.count; ++r, ++rows) {
+            for (size_t i = 0; i < in.size(); ++i) in[i] = (r >> i) & 1;
+            simulate(scalar, in.data(), out.data());
+            for (size_t o = 0; o < out.size(); ++o) passed &= block.out(o, r) == out[o];
+        }
+    }, 8);
+    passed &= rows == (1u << 16);
+
+    // Checking against an exhaustive table goes through the cones too; the
+    // solution's inputs are matched to table columns by name
+    std::string path = (std::filesystem::temp_directory_path() / "minlab_test_pairs.mlt").string();
+    writeTable(ast, net, path, 2);
+    ExpectedTable table = ExpectedTable::fromFile(ast.inputs, ast.outputs, path);
+    AST wrongAst = parseHDL(pairsHDL(3, true));
+    Net wrong = buildNet(wrongAst);
+    MismatchTally tally = checkTable(wrong, wrongAst.inputs, wrongAst.outputs, table, SimEngine::Netlist, 2);
+    passed &= tally.failedCases == 1u << 15 && tally.perOutput[3] == 1u << 15 && tally.failures.size() == 2 &&
+              tally.failures[0].c == 64 && tally.failures[1].c == 65 && tally.failures[0].got[3] == 1;
+    for (size_t o = 0; o < tally.perOutput.size(); ++o) passed &= o == 3 || tally.perOutput[o] == 0;
+    AST rightAst = parseHDL(pairsHDL(SIZE_MAX, true));
+    Net right = buildNet(rightAst);
+    passed &= checkTable(right, rightAst.inputs, rightAst.outputs, table, SimEngine::Aig, 2).failedCases == 0;
+    std::filesystem::remove(path);
+    printResult("test_output_support", passed);
+}
+
+void test_output_cones() {
+    AST ast = parseHDL(randomHDL(10, 150, 0xC04E));
+    Net net = buildNet(ast);
+    Net cone = coneNet(net, {"o2", "o0"});
+    bool passed = cone.gates.size() < net.gates.size() && cone.outputIds.size() == 2 &&
+                  cone.ast.outputs == std::vector<std::string>{"o2", "o0"} && cone.inputIds.size() == 10;
+    std::vector<uint8_t> in(10), full(3), part(2);
+    for (InputVector v : InputVectors(10)) {
+        v.unpack(in.data(), in.size());
+        simulate(net, in.data(), full.data());
+        simulate(cone, in.data(), part.data());
+        passed &= part[0] == full[2] && part[1] == full[0];
+    }
+    auto res = simulate(net, {{"i3", 1}, {"i7", 1}}, {"o1"});
+    std::unordered_map<std::string, int> vec;
+    for (size_t i = 0; i < 10; ++i) vec[ast.inputs[i]] = i == 3 || i == 7;
+    passed &= res.size() == 1 && res.at("o1") == simulate(net, vec).at("o1");
+
+    // Latch state survives cone-only evaluation
+    Net latch = buildNet(parseHDL("Inputs: s, r, x;\nOutputs: q, y;\nParts: n1:nor, n2:nor, g:not;\n"
+                                  "Wires: r->n1.in1, n2.out->n1.in2, s->n2.in1, n1.out->n2.in2, n1.out->q, "
+                                  "x->g.in, g.out->y;\n"));
+    passed &= simulate(latch, {{"s", 1}, {"r", 0}}, {"q"}).at("q") == 1;
+    passed &= simulate(latch, {{"s", 0}, {"r", 0}}, {"q"}).at("q") == 1;
+    passed &= coneNet(latch, {"y"}).gates.size() == 1 && coneNet(latch, {"q"}).cyclic;
+    try {
+        coneNet(net, {"nope"});
+        passed = false;
+    } catch (const std::runtime_error&) {
+    }
+    printResult("test_output_cones", passed);
+}
+
+// Same ports as rippleAdderHDL, built from NAND gates only (nine per bit).
+// With `trap`, s0 is also flipped when every input is 1.
+static std::string nandAdderHDL(int bits, bool trap = false) {
+    std::ostringstream in, out, parts, wires;
+    in << "Inputs: cin";
+    out << "Outputs: cout";
+    std::string carry = "cin";
+    std::vector<std::string> all = {"cin"};
+    for (int i = 0; i < bits; ++i) {
+        std::string s = std::to_string(i), a = "a" + s, b = "b" + s;
+        in << ", " << a << ", " << b;
+        out << ", s" << s;
+        all.push_back(a);
+        all.push_back(b);
+        for (int k = 1; k <= 9; ++k) parts << (i || k > 1 ? ", " : "") << "n" << k << "_" << s << ":nand";
+        auto g = [&](int k) { return "n" + std::to_string(k) + "_" + s; };
+        // a^b = n4, via n1 = nand(a,b); sum = n8 from n4^carry; carry out = nand(n1, n5)
+        wires << (i ? ", " : "") << a << "->" << g(1) << ".in1, " << b << "->" << g(1) << ".in2, "
+              << a << "->" << g(2) << ".in1, " << g(1) << ".out->" << g(2) << ".in2, "
+              << b << "->" << g(3) << ".in1, " << g(1) << ".out->" << g(3) << ".in2, "
+              << g(2) << ".out->" << g(4) << ".in1, " << g(3) << ".out->" << g(4) << ".in2, "
+              << g(4) << ".out->" << g(5) << ".in1, " << carry << "->" << g(5) << ".in2, "
+              << g(4) << ".out->" << g(6) << ".in1, " << g(5) << ".out->" << g(6) << ".in2, "
+              << carry << "->" << g(7) << ".in1, " << g(5) << ".out->" << g(7) << ".in2, "
+              << g(6) << ".out->" << g(8) << ".in1, " << g(7) << ".out->" << g(8) << ".in2, "
+              << g(1) << ".out->" << g(9) << ".in1, " << g(5) << ".out->" << g(9) << ".in2";
+        if (i > 0 || !trap) wires << ", " << g(8) << ".out->s" << s;
+        carry = g(9) + ".out";
+    }
+    wires << ", " << carry << "->cout";
+    if (trap) {
+        parts << ", t0:and";
+        wires << ", " << all[0] << "->t0.in1, " << all[1] << "->t0.in2";
+        for (size_t k = 2; k < all.size(); ++k) {
+            parts << ", t" << k - 1 << ":and";
+            wires << ", t" << k - 2 << ".out->t" << k - 1 << ".in1, " << all[k] << "->t" << k - 1 << ".in2";
+        }
+        parts << ", flip:xor";
+        wires << ", n8_0.out->flip.in1, t" << all.size() - 2 << ".out->flip.in2, flip.out->s0";
+    }
+    return in.str() + ";\n" + out.str() + ";\nParts: " + parts.str() + ";\nWires: " + wires.str() + ";\n";
+}
+
+void test_sat_solver() {
+    // Five pigeons do not fit in four holes
+    SatSolver php;
+    auto p = [](uint32_t pigeon, uint32_t hole) { return pigeon * 4 + hole; };
+    for (int v = 0; v < 20; ++v) php.newVar();
+    for (uint32_t i = 0; i < 5; ++i) {
+        php.addClause({SatSolver::lit(p(i, 0)), SatSolver::lit(p(i, 1)), SatSolver::lit(p(i, 2)), SatSolver::lit(p(i, 3))});
+    }
+    for (uint32_t h = 0; h < 4; ++h) {
+        for (uint32_t i = 0; i < 5; ++i) {
+            for (uint32_t j = i + 1; j < 5; ++j) php.addClause({SatSolver::lit(p(i, h), true), SatSolver::lit(p(j, h), true)});
+        }
+    }
+    bool passed = php.solve() == SatSolver::Result::Unsat;
+
+    // Random 3-SAT near the threshold, checked against brute force
+    uint64_t seed = 0x5A7;
+    auto next = [&]() { seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; return seed; };
+    int sat = 0;
+    for (int round = 0; round < 20; ++round) {
+        const uint32_t vars = 14;
+        std::vector<std::array<uint32_t, 3>> clauses(60);
+        SatSolver solver;
+        for (uint32_t v = 0; v < vars; ++v) solver.newVar();
+        for (auto& c : clauses) {
+            for (auto& l : c) l = SatSolver::lit(static_cast<uint32_t>(next() % vars), next() & 1);
+            solver.addClause({c[0], c[1], c[2]});
+        }
+        auto holds = [&](auto value) {
+            for (const auto& c : clauses) {
+                bool any = false;
+                for (uint32_t l : c) any |= value(l >> 1) != (l & 1);
+                if (!any) return false;
+            }
+            return true;
+        };
+        bool brute = false;
+        for (uint32_t m = 0; m < (1u << vars) && !brute; ++m) brute = holds([&](uint32_t v) { return (m >> v) & 1; });
+        SatSolver::Result r = solver.solve();
+        passed &= (r == SatSolver::Result::Sat) == brute;
+        if (r == SatSolver::Result::Sat) {
+            passed &= holds([&](uint32_t v) { return solver.value(v); });
+            ++sat;
+        }
+    }
+    passed &= sat > 0 && sat < 20;
+    printResult("test_sat_solver", passed);
+}
+
+void test_equivalence() {
+    Net ripple = buildNet(parseHDL(rippleAdderHDL(16)));
+    Net nand = buildNet(parseHDL(nandAdderHDL(16)));
+    Net trap = buildNet(parseHDL(nandAdderHDL(16, true)));
+    auto start = std::chrono::steady_clock::now();
+    bool passed = checkEquivalence(ripple, nand, 0, 0).equivalent;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    passed &= checkEquivalence(ripple, nand).equivalent;
+
+    // Wrong on one vector out of 2^33: random vectors miss it, the solver
+    // and the BDDs do not
+    for (size_t bddNodes : {size_t{0}, kEquivalenceBddNodes}) {
+        EquivalenceResult r = checkEquivalence(trap, ripple, 0, bddNodes);
+        passed &= !r.equivalent && r.differing == std::vector<std::string>{"s0"} &&
+                  std::all_of(r.counterexample.begin(), r.counterexample.end(), [](int v) { return v == 1; });
+        size_t s0 = 1;  // outputs are cout, s0, s1, ...
+        passed &= r.outA[s0] != r.outB[s0] && r.outA[0] == r.outB[0];
+    }
+
+    try {
+        checkEquivalence(ripple, buildNet(parseHDL(rippleAdderHDL(15))));
+        passed = false;
+    } catch (const std::runtime_error&) {
+    }
+    printResult("test_equivalence", passed, std::to_string(static_cast<int>(ms)) + " ms for a 16-bit adder");
+}
+
+void test_reference_levels() {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "minlab_test_reference";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string hdl = rippleAdderHDL(12);
+    AST ast = parseHDL(hdl);
+    std::ofstream(dir / "adder.hdl") << hdl;
+    for (std::string ref : {"adder.hdl", "missing.hdl"}) {
+        writeLevelJson(dir, ref, ast.inputs, ast.outputs, "\"reference_file\": \"" + ref + "\"");
+    }
+    Game game;
+    bool passed = game.loadLevels(dir.string()) && game.getLevels().size() == 1;
+    const Level* level = game.getLevel("adder.hdl");
+    passed &= level && level->expected.cases == 0 && level->reference == hdl;
+    if (passed) {
+        passed &= game.validateSolution(*level, nandAdderHDL(12)) && !game.validateSolution(*level, nandAdderHDL(12, true));
+    }
+    fs::remove_all(dir);
+    printResult("test_reference_levels", passed);
+}
+
+void test_bdd_package() {
+    BddManager mgr(3);
+    Bdd x = mgr.var(0), y = mgr.var(1), z = mgr.var(2);
+    // Canonical: equal functions are equal handles however they were built
+    bool passed = ((x & y) | (~x & z)) == mgr.ite(x, y, z) && ~(x & y) == (~x | ~y) && (x ^ x).isFalse();
+    passed &= mgr.satCount(x ^ y ^ z) == 4 && mgr.satCount(x & y) == 2 && mgr.satCount(mgr.constant(true)) == 8;
+    std::vector<int> sat = mgr.satisfyingAssignment(x & ~y & z);
+    passed &= sat == std::vector<int>{1, 0, 1} && mgr.satisfyingAssignment(x & ~x).empty();
+
+    // a == b with every a above every b needs 3*2^n nodes; sifting
+    // interleaves them, leaving 3n - 1
+    const uint32_t n = 10;
+    BddManager cmp(2 * n);
+    cmp.setAutoReorder(false);
+    Bdd eq = cmp.constant(true);
+    for (uint32_t i = 0; i < n; ++i) eq = eq & ~(cmp.var(i) ^ cmp.var(n + i));
+    size_t before = cmp.nodeCount({eq});
+    cmp.reorder();
+    passed &= before > 3000 && cmp.nodeCount({eq}) == 3 * n - 1 && cmp.satCount(eq) == 1024;
+    uint64_t seed = 0xBDD;
+    for (int round = 0; round < 200; ++round) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        std::vector<int> v(2 * n);
+        bool equal = true;
+        for (uint32_t i = 0; i < n; ++i) {
+            v[i] = (seed >> i) & 1;
+            v[n + i] = round & 1 ? v[i] : (seed >> (n + i)) & 1;
+            equal &= v[i] == v[n + i];
+        }
+        passed &= cmp.evaluate(eq, v) == equal;
+    }
+
+    // Past the node limit an operation throws and leaves only garbage behind
+    BddManager small(2 * n, 200);
+    small.setAutoReorder(false);
+    bool threw = false;
+    try {
+        Bdd e = small.constant(true);
+        for (uint32_t i = 0; i < n; ++i) e = e & ~(small.var(i) ^ small.var(n + i));
+    } catch (const BddLimitError&) {
+        threw = true;
+    }
+    small.collectGarbage();
+    passed &= threw && small.liveNodes() == 0 && small.satCount(small.var(0) & small.var(n)) == std::ldexp(1.0, 2 * n - 2);
+    printResult("test_bdd_package", passed, std::to_string(before) + " -> " + std::to_string(cmp.nodeCount({eq})) +
+                                                " nodes after sifting");
+}
+
+void test_net_bdds() {
+    // 65 inputs: counted without enumerating, and checked against simulate()
+    Net ripple = buildNet(parseHDL(rippleAdderHDL(32)));
+    Net nand = buildNet(parseHDL(nandAdderHDL(32)));
+    BddManager mgr;
+    std::vector<Bdd> f = buildBdds(mgr, ripple);
+    std::vector<Bdd> g = buildBdds(mgr, nand);
+    bool passed = f == g && mgr.nodeCount(f) < 2000;
+    passed &= mgr.satCount(f[0]) == std::ldexp(1.0, 64) && mgr.satCount(f[1]) == std::ldexp(1.0, 64);
+    uint64_t seed = 0xADD;
+    for (int round = 0; round < 50; ++round) {
+        std::unordered_map<std::string, int> in;
+        std::vector<int> v;
+        for (const auto& name : ripple.ast.inputs) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            v.push_back(seed & 1);
+            in[name] = v.back();
+        }
+        auto out = simulate(ripple, in);
+        for (size_t o = 0; o < f.size(); ++o) passed &= mgr.evaluate(f[o], v) == (out[ripple.ast.outputs[o]] == 1);
+    }
+
+    // Components with the same function are found by their BDD roots
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "minlab_test_bdd_components";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::ofstream(dir / "and_a.hdl") << "# Name: and_a\n"
+                                        "Inputs: a, b;\nOutputs: out;\nParts: n1:nand, n2:nand;\n"
+                                        "Wires: a->n1.in1, b->n1.in2, n1.out->n2.in1, n1.out->n2.in2, n2.out->out;\n";
+    std::ofstream(dir / "and_b.hdl") << "# Name: and_b\n"
+                                        "Inputs: x, y;\nOutputs: z;\nParts: n1:nand, n2:nand, i:nand;\n"
+                                        "Wires: y->n1.in1, x->n1.in2, x->n2.in1, y->n2.in2,"
+                                        " n1.out->i.in1, n2.out->i.in2, i.out->z;\n";
+    std::ofstream(dir / "nand_c.hdl") << "# Name: nand_c\n"
+                                         "Inputs: a, b;\nOutputs: out;\nParts: n:nand;\n"
+                                         "Wires: a->n.in1, b->n.in2, n.out->out;\n";
+    ComponentLibrary lib;
+    lib.loadComponents(dir.string());
+    passed &= lib.findDuplicates("and_a") == std::vector<std::string>{"and_b"} && lib.findDuplicates("nand_c").empty();
+    fs::remove_all(dir);
+    printResult("test_net_bdds", passed, std::to_string(mgr.nodeCount(f)) + " nodes for a 32-bit adder");
+}
+
+int main() {
+    std::cout << "Running Simulator Tests..." << std::endl;
+    std::cout << "====================================" << std::endl;
+
+    test_basic_gates();
+    test_wire_chains_and_undriven_pins();
+    test_unknown_pins_throw();
+    test_ripple_adder();
+    test_deep_chain();
+    test_sr_latch();
+    test_feedback_loops_confined();
+    test_event_driven_matches_levelized();
+    test_input_vectors();
+    test_bit_parallel_truth_table();
+    test_parallel_enumeration_order();
+    test_incremental_cones();
+    test_gate_kernels_agree();
+    test_optimizer_preserves_function();
+    test_custom_components();
+    test_nested_components_flattened();
+    test_component_lookup_tables();
+    test_aig_engine();
+    test_bytecode_matches_levelized();
+    test_native_engine();
+    test_truth_file();
+    test_row_formats();
+    test_validate_solution();
+    test_compact_levels();
+    test_output_support();
+    test_output_cones();
+    test_sat_solver();
+    test_equivalence();
+    test_reference_levels();
+    test_bdd_package();
+    test_net_bdds();
+
+    std::cout << "====================================" << std::endl;
+    std::cout << "Tests completed!" << std::endl;
+
+    return g_failures == 0 ? 0 : 1;
+}